@@ -0,0 +1,144 @@
+/**
+ * Benchmark of the loader, the crossing kernels and the strategies on a single instance.
+ * Reads a graph in the format of the Graph Drawing 2015 challenge from the standard input and prints
+ * CSV rows "instance,vertices,edges,pages,measure,seconds,crossings", e.g.
+ * "gen_complete 4 30 | benchmark complete_4_30". The whole corpus is run by "make bench".
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bestfound.h"
+#include "graph.h"
+#include "loader.h"
+#include "strategies.h"
+#include "tools.h"
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Random pages, always from the same seed, so that every kernel starts from the same drawing.
+ */
+static void randomPages(Graph *gr)
+{
+  std::mt19937 mt(1);
+  std::uniform_int_distribution<int> pageDistrib(0, gr->p - 1);
+  for (Edge &ed : gr->e)
+    gr->setPage(&ed, pageDistrib(mt));
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 2)
+  {
+    cerr << "Exactly one argument is required -- the name of the instance in the output." << endl;
+    return 0;
+  }
+  string name = argv[1];
+
+  // The strategies report their progress to cout; only the CSV rows are printed.
+  std::ostream csv(cout.rdbuf());
+  cout.rdbuf(nullptr);
+
+  Graph origGr;
+  Clock::time_point start = Clock::now();
+  Loader::load(std::cin, &origGr);
+  double loadTime = secondsSince(start);
+  Graph randGr(origGr);
+  randomPages(&randGr);
+  int n = randGr.v.size();
+
+  auto row = [&](const string &measure, double seconds, long long crossings)
+  {
+    csv << name << "," << n << "," << origGr.e.size() << "," << origGr.p << ","
+        << measure << "," << seconds << "," << crossings << endl;
+  };
+
+  row("loadText", loadTime, Tools::countCrossingNumberFast(origGr));
+
+  start = Clock::now();
+  int cr = Tools::countCrossingNumber(randGr);
+  row("countCrossingNumber", secondsSince(start), cr);
+
+  start = Clock::now();
+  cr = Tools::countCrossingNumberFast(randGr);
+  row("countCrossingNumberFast", secondsSince(start), cr);
+
+  // The best position of every vertex; crossings is the sum of the improvements.
+  start = Clock::now();
+  long long diffSum = 0;
+  for (int v = 0; v < n; v++)
+  {
+    int pos = 0;
+    diffSum += Tools::findBestPositionForVertex(randGr, v, &pos);
+  }
+  row("findBestPositionForVertex", secondsSince(start), diffSum);
+
+  {
+    Graph gr(randGr);
+    start = Clock::now();
+    Tools::greedyPages(&gr);
+    row("greedyPages", secondsSince(start), Tools::countCrossingNumberFast(gr));
+  }
+
+  {
+    Graph gr(randGr);
+    std::mt19937 mt(2);
+    std::uniform_int_distribution<int> vertexDistrib(0, n - 1);
+    start = Clock::now();
+    for (int i = 0; i < 10 * n; i++)
+    {
+      // Drawn one by one; the evaluation order of the arguments is unspecified.
+      int vOld = vertexDistrib(mt);
+      int vNew = vertexDistrib(mt);
+      Tools::moveVertex(&gr, vOld, vNew);
+    }
+    row("moveVertex", secondsSince(start), Tools::countCrossingNumberFast(gr));
+  }
+
+  {
+    Graph gr(origGr);
+    BestFound best("", gr);
+    start = Clock::now();
+    cr = Strategies::GreedyBB(&gr, &best);
+    row("GreedyBB", secondsSince(start), cr);
+  }
+
+  {
+    Graph gr(origGr);
+    BestFound best("", gr);
+    start = Clock::now();
+    cr = Strategies::BBGreedy(&gr, &best);
+    row("BBGreedy", secondsSince(start), cr);
+  }
+
+  {
+    Graph gr(randGr);
+    BestFound best("", gr);
+    std::mt19937 mt(3);
+    start = Clock::now();
+    cr = Strategies::simAnneal(&gr, 64, &best, mt);
+    row("simAnneal", secondsSince(start), cr);
+  }
+  return 0;
+}
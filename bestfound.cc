@@ -7,6 +7,7 @@ using std::cerr;
 using std::endl;
 
 #include "tools.h"
+#include "stats.h"
 
 void BestFound::writeGraph(const Graph &g, std::ostream &ostr)
 {
@@ -18,76 +19,147 @@ void BestFound::writeGraph(const Graph &g, std::ostream &ostr)
     ostr << g.v[e.v1].id << " " << g.v[e.v2].id << " [" << e.p << "]" << endl;
 }
 
-void BestFound::verifyGraphBadCase(string msg)
+/**
+ * Called by the writer thread, so the error is kept for the owner instead of stopping the process.
+ * Always returns false.
+ */
+bool BestFound::verifyGraphBadCase(string msg)
 {
   cerr << "The graph is bad!!! " << msg << endl;
-  exit(0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  error_ = msg;
+  return false;
 }
 
-void BestFound::verifyGraph(const Graph &gr, int claimedCr)
+/**
+ * Checks that ids is a permutation of the vertex ids and the pages are in range before it builds
+ * the drawing to target and counts its crossings.
+ * @return true iff ids and pages give a drawing of origGr_ with claimedCr crossings.
+ */
+bool BestFound::verifyGraph(const vector<int> &ids, const vector<int> &pages, int claimedCr,
+                            Graph *target)
 {
-  if (Tools::countCrossingNumber(gr) != claimedCr)
-    verifyGraphBadCase("Number of crossings differs from the claimend value.");
-  if (origGr_.v.size() != gr.v.size())
-    verifyGraphBadCase("Number of vertices changed.");
-  if (origGr_.e.size() != gr.e.size())
-    verifyGraphBadCase("Number of edges changed.");
-  int n = static_cast<int>(gr.v.size());
-  int m = static_cast<int>(gr.e.size());
-  if (origGr_.p != gr.p)
-    verifyGraphBadCase("Numbers of pages changed.");
+  if (origGr_.v.size() != ids.size())
+    return verifyGraphBadCase("Number of vertices changed.");
+  if (origGr_.e.size() != pages.size())
+    return verifyGraphBadCase("Number of edges changed.");
+  int n = static_cast<int>(ids.size());
 
   vector<bool> used(n, false);
-  for (const Vertex &ver : gr.v)
+  for (int id : ids)
   {
-    if (ver.id < 0 || ver.id >= n || used[ver.id])
-      verifyGraphBadCase(
-          "Bad or duplicate vertex id " + std::to_string(ver.id) + ".");
-    used[ver.id] = true;
-  }
-  for (int i = 0; i < m; i++)
-  {
-    if (gr.v[gr.e[i].v1].id != origGr_.v[origGr_.e[i].v1].id)
-    {
-      writeGraph(origGr_, cout);
-      writeGraph(gr, cout);
-      verifyGraphBadCase(
-          "An edge changed; the first vertex of edge " + std::to_string(i));
-    }
-    if (gr.v[gr.e[i].v2].id != origGr_.v[origGr_.e[i].v2].id)
-    {
-      writeGraph(origGr_, cout);
-      writeGraph(gr, cout);
-      verifyGraphBadCase(
-          "An edge changed; the second vertex of edge " + std::to_string(i));
-    }
-    if (gr.e[i].p < 0 || gr.e[i].p >= gr.p)
-      verifyGraphBadCase("Edge page is out of range.");
+    if (id < 0 || id >= n || used[id])
+      return verifyGraphBadCase("Bad or duplicate vertex id " + std::to_string(id) + ".");
+    used[id] = true;
   }
+  for (int page : pages)
+    if (page < 0 || page >= origGr_.p)
+      return verifyGraphBadCase("Edge page is out of range.");
+  Tools::buildDrawing(origGr_, ids, pages, target);
+  if (Tools::countCrossingNumberFast(*target) != claimedCr)
+    return verifyGraphBadCase("Number of crossings differs from the claimend value.");
+  return true;
 }
 
 /**
- * @param claimedCr The claimed crossing number of the candidate (it is also verified here). Value of -1 means that it should be counted here.
+ * @param claimedCr The claimed crossing number of the candidate (it is verified later by the writer). Value of -1 means that it should be counted here.
  *
  */
 void BestFound::testIfBest(const Graph &candidate, int claimedCr)
 {
+  int cur = val_.load(std::memory_order_relaxed);
+  if (claimedCr != -1 && cur != -1 && claimedCr >= cur)
+    return;
   if (claimedCr == -1)
-    claimedCr = Tools::countCrossingNumber(candidate);
+    claimedCr = Tools::countCrossingNumberFast(candidate);
 
+  std::lock_guard<std::mutex> lock(mutex_);
   if (val_ != -1 && claimedCr >= val_)
     return;
 
   val_ = claimedCr;
-  gr_.loadFrom(candidate);
+  Tools::storeDrawing(candidate, &ids_, &pages_);
   betterThanInitial_ = true;
 
-  if (filename_ == "")
+  if (!writer_.joinable())
+    return;
+  pendingCr_ = claimedCr;
+  writerWake_.notify_one();
+}
+
+void BestFound::copyGraph(Graph *target) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  Tools::buildDrawing(origGr_, ids_, pages_, target);
+}
+
+BestFound::~BestFound()
+{
+  if (!writer_.joinable())
     return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  writerWake_.notify_one();
+  writer_.join();
+}
 
-  verifyGraph(candidate, claimedCr);
+void BestFound::flush()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  writerIdle_.wait(lock, [this]()
+  { return pendingCr_ == -1 && !writing_;});
+}
+
+/**
+ * Takes a copy of the vertex ids and pages of the pending best drawing and builds, verifies and writes
+ * the drawing outside of the lock, so the searching threads only wait for the copy of the arrays.
+ * The pending drawing is written even when stopping.
+ */
+void BestFound::writerLoop()
+{
+  vector<int> ids, pages;
+  Graph snapshot;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    writerWake_.wait(lock, [this]()
+    { return pendingCr_ != -1 || stopping_;});
+    if (pendingCr_ == -1)
+      return;
+    int cr = pendingCr_;
+    pendingCr_ = -1;
+    ids = ids_;
+    pages = pages_;
+    writing_ = true;
+    lock.unlock();
+    writeFile(ids, pages, cr, &snapshot);
+    lock.lock();
+    writing_ = false;
+    if (pendingCr_ == -1)
+      writerIdle_.notify_all();
+  }
+}
 
-  cout << "Writing graph with: " << claimedCr << " crossings.  \r";
+/**
+ * Verifies the drawing given by ids and pages (built to g), passes it to the listener and writes it.
+ */
+void BestFound::writeFile(const vector<int> &ids, const vector<int> &pages, int cr, Graph *g)
+{
+  Stats::Timer timer(Stats::VerifyAndWrite);
+  if (!verifyGraph(ids, pages, cr, g))
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = "";
+  }
+
+  if (listener_)
+    listener_(*g, cr);
+  if (filename_ == "")
+    return;
+  cout << "Writing graph with: " << cr << " crossings.  \r";
   cout.flush();
   // make a backup
   std::remove(filenameBck_.c_str());
@@ -97,5 +169,5 @@ void BestFound::testIfBest(const Graph &candidate, int claimedCr)
   ostr.open(filename_.c_str(), std::ios_base::out);
   if (!ostr.is_open())
     return;
-  writeGraph(candidate, ostr);
+  writeGraph(*g, ostr);
 }
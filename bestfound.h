@@ -7,41 +7,98 @@
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <random>
+#include <thread>
+#include <vector>
 
 #include "graph.h"
 
+/**
+ * Keeps the best drawing found so far and writes it to the file.
+ * All the methods may be called from several threads at once.
+ * The best value is atomic, so candidates that are not better are rejected without locking.
+ * The best drawing is kept as the vertex ids in order and the pages of the edges, so an improvement
+ * only copies two arrays into reused buffers; the graph is built from them when it is needed.
+ * If there is a file or a listener, the improvements are verified and written (and passed to the listener)
+ * by a background writer thread; when several improvements come before the writer gets to them,
+ * only the last one is written. A drawing that fails the verification is not written and its
+ * error is kept for the owner (see error).
+ */
 class BestFound
 {
  public:
-  BestFound(std::string filename, Graph &origGr)
+  /**
+   * Called by the writer thread with every verified drawing and its number of crossings.
+   */
+  typedef std::function<void(const Graph &g, int cr)> Listener;
+
+  BestFound(std::string filename, Graph &origGr, Listener listener = nullptr)
       : filename_(filename),
         filenameBck_(filename + ".bck"),
-        origGr_(origGr)
+        origGr_(origGr),
+        listener_(listener)
   {
+    if (filename_ != "" || listener_)
+      writer_ = std::thread(&BestFound::writerLoop, this);
     testIfBest(origGr, -1);
     betterThanInitial_ = false; // must be here, because testIfBest changes it to true
   }
 
+  ~BestFound();
+
+  BestFound(const BestFound &other) = delete;
+  BestFound& operator=(const BestFound &other) = delete;
+
   void testIfBest(const Graph &candidate, int claimedCr);
 
   int val() const
   {
-    return val_;
+    return val_.load();
   }
 
-  const Graph &gr() const
+  /**
+   * Waits until the current best drawing is verified and written to the file.
+   */
+  void flush();
+
+  /**
+   * Copies the best drawing to target. Time O(n + m).
+   */
+  void copyGraph(Graph *target) const;
+
+  /**
+   * Copies the vertex ids in the order of the best drawing and the pages of its edges.
+   */
+  void copyLayout(std::vector<int> *ids, std::vector<int> *pages) const
   {
-    return gr_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    *ids = ids_;
+    *pages = pages_;
+  }
+
+  /**
+   * The reason why the last drawing verified by the writer failed, or "" if it passed.
+   * After flush, it tells whether the best drawing was written.
+   */
+  std::string error() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return error_;
   }
 
   bool betterThanInitial() const
   {
+    std::lock_guard<std::mutex> lock(mutex_);
     return betterThanInitial_;
   }
 
   void restart()
   {
+    std::lock_guard<std::mutex> lock(mutex_);
     val_ = -1;
     betterThanInitial_ = false;
   }
@@ -49,16 +106,32 @@ class BestFound
  private:
   std::string filename_ = "";
   std::string filenameBck_ = "";
-  int val_ = -1;
-  Graph gr_;
+  std::atomic<int> val_{-1};
+  std::vector<int> ids_, pages_;  ///< The best drawing.
   Graph origGr_;
+  std::string error_;
+  Listener listener_;
   bool betterThanInitial_ = false;
+  mutable std::mutex mutex_;
+
+  // The writer thread; all guarded by mutex_.
+  std::thread writer_;
+  std::condition_variable writerWake_;
+  std::condition_variable writerIdle_;
+  int pendingCr_ = -1;  ///< The value of the best drawing if it is not written yet, -1 otherwise.
+  bool writing_ = false;
+  bool stopping_ = false;
+
+  void writerLoop();
+
+  void writeFile(const std::vector<int> &ids, const std::vector<int> &pages, int cr, Graph *g);
 
   void writeGraph(const Graph &g, std::ostream &ostr);
 
-  void verifyGraphBadCase(std::string msg);
+  bool verifyGraphBadCase(std::string msg);
 
-  void verifyGraph(const Graph &gr, int claimedCr);
+  bool verifyGraph(const std::vector<int> &ids, const std::vector<int> &pages, int claimedCr,
+                   Graph *target);
 };
 
 #endif /* BESTFOUND_H_ */
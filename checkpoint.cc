@@ -0,0 +1,310 @@
+/**
+ * Saving the state of the restarts of the solver to a binary file, so that a stopped run can continue.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "checkpoint.h"
+#include "tools.h"
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace
+{
+
+const char magic[8] = { 'B', 'E', 'C', 'K', 'P', 'T', '0', '1' };
+
+void writeInt(std::ostream &ostr, std::int64_t val)
+{
+  ostr.write(reinterpret_cast<const char *>(&val), sizeof(val));
+}
+
+void writeInts(std::ostream &ostr, const vector<int> &vals)
+{
+  writeInt(ostr, vals.size());
+  for (int val : vals)
+  {
+    std::int32_t v32 = val;
+    ostr.write(reinterpret_cast<const char *>(&v32), sizeof(v32));
+  }
+}
+
+void writeString(std::ostream &ostr, const string &str)
+{
+  writeInt(ostr, str.size());
+  ostr.write(str.data(), str.size());
+}
+
+/**
+ * The readers set the fail bit of istr on a short or a corrupted file.
+ */
+std::int64_t readInt(std::istream &istr)
+{
+  std::int64_t val = 0;
+  istr.read(reinterpret_cast<char *>(&val), sizeof(val));
+  return val;
+}
+
+vector<int> readInts(std::istream &istr, std::int64_t maxSize)
+{
+  std::int64_t size = readInt(istr);
+  if (size < 0 || size > maxSize)
+  {
+    istr.setstate(std::ios::failbit);
+    return vector<int>();
+  }
+  vector<int> vals(size);
+  for (int &val : vals)
+  {
+    std::int32_t v32 = 0;
+    istr.read(reinterpret_cast<char *>(&v32), sizeof(v32));
+    val = v32;
+  }
+  return vals;
+}
+
+string readString(std::istream &istr)
+{
+  std::int64_t size = readInt(istr);
+  if (size < 0 || size > (1 << 20))
+  {
+    istr.setstate(std::ios::failbit);
+    return string();
+  }
+  string str(size, '\0');
+  istr.read(&str[0], size);
+  return str;
+}
+
+}
+
+Checkpoint::Checkpoint(const string &filename, const Graph &origGr,
+                       int taskCnt, double interval)
+    : filename_(filename),
+      origGr_(origGr),
+      interval_(interval),
+      hash_(1469598103934665603ULL),
+      done_(taskCnt, 0),
+      lastUpdate_(taskCnt, Clock::now()),
+      lastWrite_(Clock::now())
+{
+  // FNV-1a of the edges given by the ids of their end-points.
+  for (const Edge &ed : origGr.e)
+    for (int id : { origGr.v[ed.v1].id, origGr.v[ed.v2].id })
+    {
+      hash_ ^= static_cast<unsigned>(id);
+      hash_ *= 1099511628211ULL;
+    }
+}
+
+void Checkpoint::restoreGraph(const vector<int> &ids, const vector<int> &pages,
+                              Graph *target) const
+{
+  Tools::buildDrawing(origGr_, ids, pages, target);
+}
+
+void Checkpoint::restoreRng(const string &rng, std::mt19937 *mt)
+{
+  std::istringstream istr(rng);
+  istr >> *mt;
+}
+
+bool Checkpoint::isDone(int task) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return task < taskCnt() && done_[task];
+}
+
+bool Checkpoint::runningState(int task, TaskState *state) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = running_.find(task);
+  if (it == running_.end())
+    return false;
+  *state = it->second;
+  return true;
+}
+
+/**
+ * The ids must be a permutation of the ids of the input graph and the pages must be in range,
+ * otherwise the file is rejected.
+ */
+bool Checkpoint::load(Graph *bestGr)
+{
+  std::ifstream istr(filename_.c_str(), std::ios::binary);
+  if (!istr.is_open())
+    return false;
+  char fileMagic[sizeof(magic)];
+  istr.read(fileMagic, sizeof(magic));
+  if (!istr || memcmp(fileMagic, magic, sizeof(magic)) != 0)
+  {
+    cerr << "Checkpoint " << filename_ << " has a wrong format." << endl;
+    return false;
+  }
+  std::int64_t n = readInt(istr);
+  std::int64_t m = readInt(istr);
+  std::int64_t p = readInt(istr);
+  std::int64_t hash = readInt(istr);
+  if (n != static_cast<std::int64_t>(origGr_.v.size())
+      || m != static_cast<std::int64_t>(origGr_.e.size()) || p != origGr_.p
+      || static_cast<unsigned long long>(hash) != hash_)
+  {
+    cerr << "Checkpoint " << filename_ << " was made for another graph." << endl;
+    return false;
+  }
+
+  auto layoutOk = [&](const vector<int> &ids, const vector<int> &pages)
+  {
+    if (static_cast<std::int64_t>(ids.size()) != n
+        || static_cast<std::int64_t>(pages.size()) != m)
+      return false;
+    vector<char> seen(n, 0);
+    for (int id : ids)
+    {
+      if (id < 0 || id >= n || seen[id])
+        return false;
+      seen[id] = 1;
+    }
+    for (int page : pages)
+      if (page < -1 || page >= p)
+        return false;
+    return true;
+  };
+
+  vector<int> bestIds = readInts(istr, n);
+  vector<int> bestPages = readInts(istr, m);
+  vector<int> done = readInts(istr, 1 << 20);
+  std::int64_t runningCnt = readInt(istr);
+  std::map<int, TaskState> running;
+  for (std::int64_t i = 0; i < runningCnt && istr; i++)
+  {
+    int task = readInt(istr);
+    TaskState &state = running[task];
+    state.stage = readInt(istr);
+    state.step = readInt(istr);
+    state.rng = readString(istr);
+    state.ids = readInts(istr, n);
+    state.pages = readInts(istr, m);
+    state.localBestVal = readInt(istr);
+    state.localBestIds = readInts(istr, n);
+    state.localBestPages = readInts(istr, m);
+    if (!layoutOk(state.ids, state.pages) || state.stage < 1 || state.stage > 2
+        || (state.localBestVal >= 0
+            && !layoutOk(state.localBestIds, state.localBestPages)))
+      istr.setstate(std::ios::failbit);
+  }
+  if (!istr || (!bestIds.empty() && !layoutOk(bestIds, bestPages)))
+  {
+    cerr << "Checkpoint " << filename_ << " is corrupted." << endl;
+    return false;
+  }
+
+  if (done.size() > done_.size())
+  {
+    done_.resize(done.size(), 0);
+    lastUpdate_.resize(done.size(), Clock::now());
+  }
+  for (unsigned i = 0; i < done.size(); i++)
+    done_[i] = done[i];
+  running_ = running;
+  if (!bestIds.empty())
+    restoreGraph(bestIds, bestPages, bestGr);
+  return true;
+}
+
+void Checkpoint::update(int task, int stage, int step, const Graph &gr,
+                        const std::mt19937 &mt, const BestFound &localBest,
+                        const BestFound &best)
+{
+  if (!due(lastUpdate_[task]))
+    return;
+  std::ostringstream rng;
+  rng << mt;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  lastUpdate_[task] = Clock::now();
+  TaskState &state = running_[task];
+  state.stage = stage;
+  state.step = step;
+  state.rng = rng.str();
+  Tools::storeDrawing(gr, &state.ids, &state.pages);
+  state.localBestVal = -1;
+  if (localBest.betterThanInitial())
+  {
+    state.localBestVal = localBest.val();
+    localBest.copyLayout(&state.localBestIds, &state.localBestPages);
+  }
+  if (due(lastWrite_))
+    write(best);
+}
+
+void Checkpoint::finishTask(int task, const BestFound &best)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  done_[task] = 1;
+  running_.erase(task);
+  write(best);
+}
+
+/**
+ * Must be called with mutex_ locked.
+ */
+void Checkpoint::write(const BestFound &best)
+{
+  lastWrite_ = Clock::now();
+  vector<int> bestIds, bestPages;
+  best.copyLayout(&bestIds, &bestPages);
+
+  string tmpName = filename_ + ".tmp";
+  {
+    std::ofstream ostr(tmpName.c_str(), std::ios::binary);
+    if (!ostr.is_open())
+    {
+      cerr << "Cannot write the checkpoint " << tmpName << endl;
+      return;
+    }
+    ostr.write(magic, sizeof(magic));
+    writeInt(ostr, origGr_.v.size());
+    writeInt(ostr, origGr_.e.size());
+    writeInt(ostr, origGr_.p);
+    writeInt(ostr, static_cast<std::int64_t>(hash_));
+    writeInts(ostr, bestIds);
+    writeInts(ostr, bestPages);
+    writeInts(ostr, vector<int>(done_.begin(), done_.end()));
+    writeInt(ostr, running_.size());
+    for (const auto &taskState : running_)
+    {
+      const TaskState &state = taskState.second;
+      writeInt(ostr, taskState.first);
+      writeInt(ostr, state.stage);
+      writeInt(ostr, state.step);
+      writeString(ostr, state.rng);
+      writeInts(ostr, state.ids);
+      writeInts(ostr, state.pages);
+      writeInt(ostr, state.localBestVal);
+      writeInts(ostr, state.localBestVal >= 0 ? state.localBestIds : vector<int>());
+      writeInts(ostr, state.localBestVal >= 0 ? state.localBestPages : vector<int>());
+    }
+    if (!ostr)
+    {
+      cerr << "Cannot write the checkpoint " << tmpName << endl;
+      return;
+    }
+  }
+  std::rename(tmpName.c_str(), filename_.c_str());
+}
@@ -0,0 +1,102 @@
+/**
+ * Saving the state of the restarts of the solver to a binary file, so that a stopped run can continue.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_CHECKPOINT_H_
+#define BOOK_EMBEDDER_CHECKPOINT_H_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+#include "bestfound.h"
+
+/**
+ * The state of the restart schedule of the solver: which tasks (iterations of the schedule) are finished,
+ * and for the running ones, the annealing they are in, its step, the random generator, the current drawing
+ * and the best drawing of the annealing. The best drawing overall is saved as well.
+ * A drawing is saved as the vertex ids in the order of the drawing and the pages of the edges, which are in
+ * the order of the input. The file is tied to the input graph by its size and a hash of its edges.
+ * The tasks save their state at most once per interval and the file is rewritten (atomically, through
+ * a temporary file) at most once per interval, so the tasks only rarely copy their drawings.
+ */
+class Checkpoint
+{
+ public:
+  struct TaskState
+  {
+    int stage = 0;  ///< 1 or 2, the first or the second annealing of the round.
+    int step = 0;  ///< The number of finished steps of the annealing.
+    std::string rng;  ///< The state of the random generator of the task.
+    std::vector<int> ids, pages;  ///< The current drawing.
+    int localBestVal = -1;  ///< -1 if the annealing did not find a better drawing yet.
+    std::vector<int> localBestIds, localBestPages;
+  };
+
+  Checkpoint(const std::string &filename, const Graph &origGr, int taskCnt, double interval);
+
+  /**
+   * Reads the file. Returns false (and changes nothing) if it is missing or was made for another graph.
+   * If the file has a best drawing, it is stored to bestGr.
+   */
+  bool load(Graph *bestGr);
+
+  int taskCnt() const
+  {
+    return static_cast<int>(done_.size());
+  }
+
+  bool isDone(int task) const;
+
+  /**
+   * Returns true and fills state if the task was running when the file was saved.
+   */
+  bool runningState(int task, TaskState *state) const;
+
+  /**
+   * Called by a running task after every step of its annealing. Does nothing until the interval passes.
+   */
+  void update(int task, int stage, int step, const Graph &gr, const std::mt19937 &mt,
+              const BestFound &localBest, const BestFound &best);
+
+  void finishTask(int task, const BestFound &best);
+
+  /**
+   * Builds the drawing of the input graph given by the vertex ids in order and the pages.
+   */
+  void restoreGraph(const std::vector<int> &ids, const std::vector<int> &pages,
+                    Graph *target) const;
+
+  static void restoreRng(const std::string &rng, std::mt19937 *mt);
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  std::string filename_;
+  const Graph &origGr_;
+  double interval_;
+  unsigned long long hash_;
+  std::vector<char> done_;
+  std::map<int, TaskState> running_;
+  std::vector<Clock::time_point> lastUpdate_;
+  Clock::time_point lastWrite_;
+  mutable std::mutex mutex_;  ///< Guards done_, running_ and lastWrite_.
+
+  bool due(Clock::time_point last) const
+  {
+    return std::chrono::duration<double>(Clock::now() - last).count() >= interval_;
+  }
+
+  void write(const BestFound &best);
+};
+
+#endif
@@ -0,0 +1,182 @@
+/**
+ * Bitsets of the pairs of edges that cross when they are on the same page, for small graphs.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <algorithm>
+
+#include "conflictmatrix.h"
+#include "tools.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BOOK_EMBEDDER_HAVE_POPCNT 1
+#endif
+
+using std::vector;
+
+bool ConflictMatrix::usePopcnt_ = ConflictMatrix::popcntAvailable();
+
+bool ConflictMatrix::popcntAvailable()
+{
+#ifdef BOOK_EMBEDDER_HAVE_POPCNT
+  __builtin_cpu_init();  // usePopcnt_ is initialized before the constructors that would do it
+  return __builtin_cpu_supports("popcnt");
+#else
+  return false;
+#endif
+}
+
+int ConflictMatrix::andCountScalar(const std::uint64_t *a, const std::uint64_t *b, int words)
+{
+  int result = 0;
+  for (int w = 0; w < words; w++)
+    result += __builtin_popcountll(a[w] & b[w]);
+  return result;
+}
+
+#ifdef BOOK_EMBEDDER_HAVE_POPCNT
+
+/**
+ * The same as andCountScalar, but compiled to the popcnt instruction.
+ */
+__attribute__((target("popcnt")))
+int ConflictMatrix::andCountPopcnt(const std::uint64_t *a, const std::uint64_t *b, int words)
+{
+  int result = 0;
+  for (int w = 0; w < words; w++)
+    result += __builtin_popcountll(a[w] & b[w]);
+  return result;
+}
+
+#else
+
+int ConflictMatrix::andCountPopcnt(const std::uint64_t *a, const std::uint64_t *b, int words)
+{
+  return andCountScalar(a, b, words);
+}
+
+#endif
+
+/**
+ * A page move costs two lookups of m/64 words each, while without the matrix it costs one scan
+ * of the span of the edge (see Tools::averageSpanScan); the rows are rebuilt about once per annealing
+ * step of m page moves, which is then paid for as well.
+ * Time O(n + m).
+ */
+bool ConflictMatrix::fits(const Graph &gr)
+{
+  if (gr.p <= 0 || gr.e.empty() || gr.e.size() > static_cast<std::size_t>(maxEdges))
+    return false;
+  int words = (static_cast<int>(gr.e.size()) + 63) / 64;
+  return Tools::averageSpanScan(gr) >= 2 * words;
+}
+
+/**
+ * Rebuilds the rows if the vertex order of gr is not the one they were built for, and the page masks
+ * from the current pages.
+ * Time O(n + m*p/64), plus O((n + m)*m/64) if the rows are rebuilt.
+ * @return true iff the rows were rebuilt.
+ */
+bool ConflictMatrix::update(const Graph &gr)
+{
+  int n = static_cast<int>(gr.v.size());
+  int m = static_cast<int>(gr.e.size());
+  bool sameOrder = (static_cast<int>(order_.size()) == n && words_ == (m + 63) / 64
+      && rows_.size() == static_cast<std::size_t>(m) * words_);
+  for (int i = 0; i < n && sameOrder; i++)
+    sameOrder = (order_[i] == gr.v[i].id);
+  if (!sameOrder)
+  {
+    order_.resize(n);
+    for (int i = 0; i < n; i++)
+      order_[i] = gr.v[i].id;
+    buildRows(gr);
+  }
+  p_ = gr.p;
+  masks_.assign(static_cast<std::size_t>(p_) * words_, 0);
+  for (int i = 0; i < m; i++)
+    if (gr.e[i].p >= 0)
+      flip(mask(gr.e[i].p), i);
+  return !sameOrder;
+}
+
+/**
+ * A sweep over the positions x keeps the bitset open of the edges (c,d) with c < x < d.
+ * An edge (a,b) with a < b interleaves with (c,d) iff (c,d) is open at exactly one of a and b
+ * and has no common end-point with it, so its row is open(a) ^ open(b) without the edges
+ * incident with a or b.
+ */
+void ConflictMatrix::buildRows(const Graph &gr)
+{
+  int n = static_cast<int>(gr.v.size());
+  int m = static_cast<int>(gr.e.size());
+  words_ = (m + 63) / 64;
+  rows_.assign(static_cast<std::size_t>(m) * words_, 0);
+  // The edges incident with every vertex, so that they are removed from a row word by word.
+  vector<std::uint64_t> incident(static_cast<std::size_t>(n) * words_, 0);
+  for (int x = 0; x < n; x++)
+    for (const Edge *ed : gr.v[x].neighs)
+      flip(incident.data() + static_cast<std::size_t>(x) * words_, index(gr, *ed));
+  vector<std::uint64_t> open(words_, 0);
+  for (int x = 0; x < n; x++)
+  {
+    const std::uint64_t *incX = incident.data() + static_cast<std::size_t>(x) * words_;
+    for (const Edge *ed : gr.v[x].neighs)
+    {
+      std::uint64_t *r = rows_.data() + static_cast<std::size_t>(index(gr, *ed)) * words_;
+      int other = ed->getOtherEnd(x);
+      if (other > x)
+        std::copy(open.begin(), open.end(), r);
+      else
+      {
+        const std::uint64_t *incOther = incident.data() + static_cast<std::size_t>(other) * words_;
+        for (int w = 0; w < words_; w++)
+          r[w] = (r[w] ^ open[w]) & ~(incX[w] | incOther[w]);
+      }
+    }
+    // From {c < x < d} to {c < x+1 < d}: add the edges starting at x, remove those ending at x+1.
+    for (const Edge *ed : gr.v[x].neighs)
+      if (ed->getOtherEnd(x) > x)
+        flip(open.data(), index(gr, *ed));
+    if (x + 1 < n)
+      for (const Edge *ed : gr.v[x + 1].neighs)
+        if (ed->getOtherEnd(x + 1) < x + 1)
+          flip(open.data(), index(gr, *ed));
+  }
+}
+
+/**
+ * The same as Tools::greedyEdgePage, but the costs of the pages are counted on the bitsets.
+ * Time O(p*m/64).
+ * @return true iff an improvement was done.
+ */
+bool ConflictMatrix::greedyEdgePage(Graph *gr, Edge *ed)
+{
+  int idx = index(*gr, *ed);
+  int origPage = ed->p;
+  int best = origPage;
+  int origCost = (origPage >= 0 ? cost(idx, origPage) : 0);
+  int bestCost = origCost;
+
+  // Find the best page other than the original.
+  for (int pCur = 0; pCur < p_; pCur++)
+    if (pCur != origPage)
+    {
+      int curCost = cost(idx, pCur);
+      if (best < 0 || curCost <= bestCost)
+      {
+        best = pCur;
+        bestCost = curCost;
+      }
+    }
+
+  if (best < 0)  // may happen if there is only one page
+    return false;
+  changePage(gr, ed, best);
+  return (origPage < 0 || bestCost < origCost);
+}
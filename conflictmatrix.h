@@ -0,0 +1,138 @@
+/**
+ * Bitsets of the pairs of edges that cross when they are on the same page, for small graphs.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_CONFLICTMATRIX_H_
+#define BOOK_EMBEDDER_CONFLICTMATRIX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "graph.h"
+
+/**
+ * For the current vertex order, row(ed) is the bitset of the edges that interleave with ed (i.e. cross it
+ * if they are on the same page), and mask(q) is the bitset of the edges on page q. The crossings of ed
+ * if it were on page q are then popcount(row(ed) & mask(q)), i.e. m/64 words, and a page change
+ * only flips two bits.
+ * The rows depend only on the vertex order; update rebuilds them only if the order changed since
+ * the last build, so a page-only phase after a few vertex moves does not pay for them again.
+ * The edges are identified by their index in gr.e. The rows take m*m/8 bytes, so only graphs with
+ * at most maxEdges edges are supported, and only dense ones, where a lookup of m/64 words is cheaper
+ * than a scan of the span of the edge (see fits).
+ */
+class ConflictMatrix
+{
+ public:
+  static const int maxEdges = 4096;
+
+  static bool fits(const Graph &gr);
+
+  bool update(const Graph &gr);
+
+  int cost(int ed, int page) const
+  {
+    return andCount(row(ed), mask(page), words_);
+  }
+
+  int cost(const Graph &gr, const Edge &ed, int page) const
+  {
+    return cost(index(gr, ed), page);
+  }
+
+  /**
+   * Change of the crossing number if ed is moved to newPage (ed must have an assigned page).
+   * Time O(m/64).
+   */
+  int pageChangeDiff(const Graph &gr, const Edge &ed, int newPage) const
+  {
+    int idx = index(gr, ed);
+    return cost(idx, newPage) - cost(idx, ed.p);
+  }
+
+  /**
+   * Moves ed to newPage (which may be -1). Time O(1).
+   */
+  void changePage(Graph *gr, Edge *ed, int newPage)
+  {
+    int idx = index(*gr, *ed);
+    if (ed->p >= 0)
+      flip(mask(ed->p), idx);
+    if (newPage >= 0)
+      flip(mask(newPage), idx);
+    gr->setPage(ed, newPage);
+  }
+
+  bool greedyEdgePage(Graph *gr, Edge *ed);
+
+  /**
+   * Calls f(i) for the index i of every edge on page that interleaves with the edge ed.
+   * Time O(m/64 + number of such edges).
+   */
+  template<class F>
+  void forEachOnPage(int ed, int page, F f) const
+  {
+    const std::uint64_t *r = row(ed);
+    const std::uint64_t *mk = mask(page);
+    for (int w = 0; w < words_; w++)
+      for (std::uint64_t bits = r[w] & mk[w]; bits != 0; bits &= bits - 1)
+        f(64 * w + __builtin_ctzll(bits));
+  }
+
+  static bool popcntAvailable();
+
+ private:
+  static bool usePopcnt_;
+
+  int p_ = 0;
+  int words_ = 0;
+  std::vector<int> order_;  ///< The ids of the vertices in the order for which the rows were built.
+  std::vector<std::uint64_t> rows_;
+  std::vector<std::uint64_t> masks_;
+
+  static int index(const Graph &gr, const Edge &ed)
+  {
+    return static_cast<int>(&ed - &gr.e[0]);
+  }
+
+  const std::uint64_t *row(int ed) const
+  {
+    return rows_.data() + static_cast<std::size_t>(ed) * words_;
+  }
+
+  const std::uint64_t *mask(int page) const
+  {
+    return masks_.data() + static_cast<std::size_t>(page) * words_;
+  }
+
+  std::uint64_t *mask(int page)
+  {
+    return masks_.data() + static_cast<std::size_t>(page) * words_;
+  }
+
+  static void flip(std::uint64_t *bits, int i)
+  {
+    bits[i >> 6] ^= std::uint64_t(1) << (i & 63);
+  }
+
+  static int andCount(const std::uint64_t *a, const std::uint64_t *b, int words)
+  {
+    if (usePopcnt_)
+      return andCountPopcnt(a, b, words);
+    return andCountScalar(a, b, words);
+  }
+
+  static int andCountScalar(const std::uint64_t *a, const std::uint64_t *b, int words);
+
+  static int andCountPopcnt(const std::uint64_t *a, const std::uint64_t *b, int words);
+
+  void buildRows(const Graph &gr);
+};
+
+#endif
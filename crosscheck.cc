@@ -0,0 +1,97 @@
+/**
+ * Check of the fast crossing counts against the straightforward ones on seeded random graphs.
+ * Exits with status 1 at the first mismatch; run by "make check".
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+#include "flatgraph.h"
+#include "graph.h"
+#include "tools.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+/**
+ * A random multigraph on n vertices in a random order, with pages in [-1, p); some of the edges
+ * are repeated (parallel edges) and some get the page -1.
+ */
+static void randomGraph(int n, int m, int p, std::mt19937 &mt, Graph *gr)
+{
+  std::uniform_int_distribution<int> vertexDistrib(0, n - 1);
+  std::uniform_int_distribution<int> pageDistrib(-1, p - 1);
+  std::uniform_int_distribution<int> percentDistrib(0, 99);
+  std::vector<int> ids(n);
+  for (int i = 0; i < n; i++)
+    ids[i] = i;
+  std::shuffle(ids.begin(), ids.end(), mt);
+  gr->p = p;
+  gr->v.clear();
+  for (int id : ids)
+    gr->v.push_back(Vertex(id));
+  gr->e.clear();
+  while (static_cast<int>(gr->e.size()) < m)
+  {
+    if (!gr->e.empty() && percentDistrib(mt) < 10)
+    {
+      Edge parallel = gr->e[std::uniform_int_distribution<int>(0, gr->e.size() - 1)(mt)];
+      parallel.p = pageDistrib(mt);
+      gr->e.push_back(parallel);
+      continue;
+    }
+    int v1 = vertexDistrib(mt);
+    int v2 = vertexDistrib(mt);
+    if (v1 != v2)
+      gr->e.push_back(Edge(v1, v2, pageDistrib(mt)));
+  }
+  gr->restoreNeighs();
+}
+
+static bool check(const char *what, int fast, int reference, int instance)
+{
+  if (fast == reference)
+    return true;
+  cerr << "Instance " << instance << ": " << what << " counts " << fast << " crossings instead of "
+       << reference << "." << endl;
+  return false;
+}
+
+int main()
+{
+  std::mt19937 mt(2015);
+  const int instanceCnt = 300;
+  bool ok = true;
+  for (int i = 0; i < instanceCnt && ok; i++)
+  {
+    int n = std::uniform_int_distribution<int>(2, 80)(mt);
+    int m = std::uniform_int_distribution<int>(0, 4 * n)(mt);
+    int p = std::uniform_int_distribution<int>(1, 5)(mt);
+    Graph gr;
+    randomGraph(n, m, p, mt, &gr);
+    FlatGraph fg(gr);
+    for (int threadCnt : { 1, 3 })
+    {
+      Tools::setEvalThreads(threadCnt);
+      int reference = Tools::countCrossingNumber(gr);
+      ok = ok && check("countCrossingNumberFast(Graph)", Tools::countCrossingNumberFast(gr),
+                       reference, i);
+      ok = ok && check("countCrossingNumber(FlatGraph)", Tools::countCrossingNumber(fg),
+                       reference, i);
+      ok = ok && check("countCrossingNumberFast(FlatGraph)", Tools::countCrossingNumberFast(fg),
+                       reference, i);
+    }
+  }
+  if (!ok)
+    return 1;
+  cout << "The fast crossing counts agree on " << instanceCnt << " random graphs." << endl;
+  return 0;
+}
@@ -0,0 +1,229 @@
+/**
+ * Crossing counts of a drawing that are kept up to date while the drawing changes.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "crossingstate.h"
+#include "tools.h"
+
+using std::vector;
+
+/**
+ * Time O(n + m log n).
+ */
+CrossingState::CrossingState(const Graph &gr)
+    : detached_(gr.e.size(), 0)
+{
+  total_ = Tools::countCrossingsPerEdge(gr, edgeCr_);
+}
+
+/**
+ * Change of the total crossing number if ed is moved to newPage. Nothing is changed.
+ * Time O(m), but faster if ed is short.
+ */
+int CrossingState::pageChangeDiff(const Graph &gr, const Edge &ed,
+                                  int newPage) const
+{
+  assert(!detached_[index(gr, ed)]);
+  Edge moved = ed;
+  moved.p = newPage;
+  return Tools::countEdgeCrossings(gr, moved) - edgeCrossings(gr, ed);
+}
+
+/**
+ * Calls f for every attached edge that crosses ed.
+ * Time O(m), but faster if ed is short.
+ */
+template<class F>
+static void forEachCrossing(const Graph &gr, const Edge &ed,
+                            const vector<char> &detached, F f)
+{
+  int v1 = std::min(ed.v1, ed.v2);
+  int v2 = std::max(ed.v1, ed.v2);
+  for (int id2 = v1 + 1; id2 < v2; id2++)
+    for (const Edge *ed2 : gr.v[id2].onPage(ed.p))
+    {
+      int e2V2 = ed2->getOtherEnd(id2);
+      if ((e2V2 < v1 || e2V2 > v2) && !detached[ed2 - &gr.e[0]])
+        f(ed2);
+    }
+}
+
+void CrossingState::detachEdge(const Graph &gr, const Edge &ed)
+{
+  int idx = index(gr, ed);
+  if (detached_[idx])
+    return;
+  forEachCrossing(gr, ed, detached_, [&](const Edge *ed2)
+  {
+    edgeCr_[index(gr, *ed2)]--;
+    edgeCr_[idx]--;
+    total_--;
+  });
+  assert(edgeCr_[idx] == 0);
+  detached_[idx] = 1;
+}
+
+void CrossingState::attachEdge(const Graph &gr, const Edge &ed)
+{
+  int idx = index(gr, ed);
+  if (!detached_[idx])
+    return;
+  assert(edgeCr_[idx] == 0);
+  forEachCrossing(gr, ed, detached_, [&](const Edge *ed2)
+  {
+    edgeCr_[index(gr, *ed2)]++;
+    edgeCr_[idx]++;
+    total_++;
+  });
+  detached_[idx] = 0;
+}
+
+/**
+ * Removes the crossings of the edges incident with the vertex at position v from all counts.
+ * Until attachVertex is called, the vertex can be moved and pages of its edges changed directly in gr.
+ * Time O(deg(v)*m), but faster if the edges are short.
+ */
+void CrossingState::detachVertex(const Graph &gr, int v)
+{
+  for (const Edge *ed : gr.v[v].neighs)
+    detachEdge(gr, *ed);
+}
+
+/**
+ * Counts the crossings of the detached edges incident with the vertex at position v again.
+ * Time O(deg(v)*m), but faster if the edges are short.
+ */
+void CrossingState::attachVertex(const Graph &gr, int v)
+{
+  for (const Edge *ed : gr.v[v].neighs)
+    attachEdge(gr, *ed);
+}
+
+/**
+ * Time O(m), but faster if ed is short.
+ */
+void CrossingState::changePage(Graph *gr, Edge *ed, int newPage)
+{
+  detachEdge(*gr, *ed);
+  gr->setPage(ed, newPage);
+  attachEdge(*gr, *ed);
+}
+
+/**
+ * The same as changePage, but cache is patched as well, within the same scan of the span of ed
+ * (over all pages). ed must be attached.
+ * Time O(m), but faster if ed is short.
+ */
+void CrossingState::changePage(Graph *gr, Edge *ed, int newPage,
+                               PageCostCache *cache)
+{
+  int idx = index(*gr, *ed);
+  assert(!detached_[idx]);
+  int oldPage = ed->p;
+  if (oldPage == newPage)
+    return;
+  PageCostCache::forEachInterleaving(*gr, *ed, [&](const Edge *ed2)
+  {
+    int idx2 = index(*gr, *ed2);
+    cache->interleavingMoved(idx2, oldPage, newPage);
+    if (detached_[idx2])
+      return;
+    int diff = (ed2->p == newPage) - (ed2->p == oldPage);
+    edgeCr_[idx2] += diff;
+    edgeCr_[idx] += diff;
+    total_ += diff;
+  });
+  gr->setPage(ed, newPage);
+}
+
+/**
+ * The same as changePage, but the crossings are found on the bitsets of conflicts, which are patched
+ * as well. conflicts must be up to date with gr and ed must be attached.
+ * Time O(m/64 + crossings of ed on the old and the new page).
+ */
+void CrossingState::changePage(Graph *gr, Edge *ed, int newPage,
+                               ConflictMatrix *conflicts)
+{
+  int idx = index(*gr, *ed);
+  assert(!detached_[idx]);
+  int oldPage = ed->p;
+  if (oldPage == newPage)
+    return;
+  auto count = [&](int page, int diff)
+  {
+    if (page < 0)
+      return;
+    conflicts->forEachOnPage(idx, page, [&](int idx2)
+    {
+      if (detached_[idx2])
+        return;
+      edgeCr_[idx2] += diff;
+      edgeCr_[idx] += diff;
+      total_ += diff;
+    });
+  };
+  count(oldPage, -1);
+  count(newPage, 1);
+  conflicts->changePage(gr, ed, newPage);
+}
+
+/**
+ * Swaps the vertices at positions v1 and v1+1.
+ * Only a pair of edges where one is incident with v1 and the other with v1+1 may start or stop crossing.
+ * Time O(pageCnt + sum over pages of deg_p(v1)*deg_p(v1+1)).
+ */
+void CrossingState::swapNeighbors(Graph *gr, int v1)
+{
+  for (int p = -1; p < gr->p; p++)
+    for (const Edge *ed1 : gr->v[v1].onPage(p))
+      for (const Edge *ed2 : gr->v[v1 + 1].onPage(p))
+      {
+        assert(!detached_[index(*gr, *ed1)] && !detached_[index(*gr, *ed2)]);
+        int ed1v2 = ed1->getOtherEnd(v1);
+        int ed2v2 = ed2->getOtherEnd(v1 + 1);
+        if (ed1v2 == ed2v2 || ed1v2 == v1 + 1 || ed2v2 == v1)
+          continue;  // they share an endpoint -> they never cross
+        bool crossBefore = Tools::doEdgesCross(*ed1, *ed2);
+        int diff = (crossBefore ? -1 : 1);
+        edgeCr_[index(*gr, *ed1)] += diff;
+        edgeCr_[index(*gr, *ed2)] += diff;
+        total_ += diff;
+      }
+  Tools::swapVertices(gr, v1, v1 + 1);
+}
+
+/**
+ * Time O((deg(vA) + deg(vB))*m), but O(deg(vA)*deg(vB)) if the vertices are next to each other.
+ */
+void CrossingState::swapVertices(Graph *gr, int vA, int vB)
+{
+  if (std::abs(vA - vB) == 1)
+  {
+    swapNeighbors(gr, std::min(vA, vB));
+    return;
+  }
+  detachVertex(*gr, vA);
+  detachVertex(*gr, vB);
+  Tools::swapVertices(gr, vA, vB);
+  attachVertex(*gr, vA);
+  attachVertex(*gr, vB);
+}
+
+/**
+ * Time O(deg(vOld)*m + cost of Tools::moveVertex), but faster if the edges are short.
+ */
+void CrossingState::moveVertex(Graph *gr, int vOld, int vNew)
+{
+  detachVertex(*gr, vOld);
+  Tools::moveVertex(gr, vOld, vNew);
+  attachVertex(*gr, vNew);
+}
@@ -0,0 +1,83 @@
+/**
+ * Crossing counts of a drawing that are kept up to date while the drawing changes.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_CROSSINGSTATE_H_
+#define BOOK_EMBEDDER_CROSSINGSTATE_H_
+
+#include <vector>
+
+#include "conflictmatrix.h"
+#include "graph.h"
+#include "pagecostcache.h"
+
+/**
+ * Owns the number of crossings of every edge and the total number of crossings of a graph.
+ * All changes of the graph must be done through the methods of this class
+ * (or between detachVertex and attachVertex), otherwise the counts become invalid.
+ * The edges are identified by their index in gr.e, so gr.e must not be reallocated.
+ */
+class CrossingState
+{
+ public:
+  CrossingState(const Graph &gr);
+
+  int total() const
+  {
+    return total_;
+  }
+
+  int edgeCrossings(const Graph &gr, const Edge &ed) const
+  {
+    return edgeCr_[index(gr, ed)];
+  }
+
+  int pageChangeDiff(const Graph &gr, const Edge &ed, int newPage) const;
+
+  void changePage(Graph *gr, Edge *ed, int newPage);
+
+  void changePage(Graph *gr, Edge *ed, int newPage, PageCostCache *cache);
+
+  void changePage(Graph *gr, Edge *ed, int newPage, ConflictMatrix *conflicts);
+
+  /**
+   * The conflict matrix of the graph, kept here so that its rows survive between the page phases
+   * as long as the vertex order does not change. It is valid only after conflicts()->update(gr).
+   */
+  ConflictMatrix *conflicts()
+  {
+    return &conflicts_;
+  }
+
+  void swapNeighbors(Graph *gr, int v1);
+
+  void swapVertices(Graph *gr, int vA, int vB);
+
+  void moveVertex(Graph *gr, int vOld, int vNew);
+
+  void detachVertex(const Graph &gr, int v);
+
+  void attachVertex(const Graph &gr, int v);
+
+ private:
+  std::vector<int> edgeCr_;  ///< Crossings of every edge with the attached edges.
+  std::vector<char> detached_;  ///< Detached edges are not counted in any crossing counts.
+  int total_ = 0;
+  ConflictMatrix conflicts_;
+
+  static int index(const Graph &gr, const Edge &ed)
+  {
+    return static_cast<int>(&ed - &gr.e[0]);
+  }
+
+  void detachEdge(const Graph &gr, const Edge &ed);
+
+  void attachEdge(const Graph &gr, const Edge &ed);
+};
+
+#endif
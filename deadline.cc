@@ -0,0 +1,62 @@
+/**
+ * The wall-clock deadline of the whole run and of the parts of the work run on behalf of a request.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+#include "deadline.h"
+
+bool Deadline::isSet_ = false;
+std::atomic<bool> Deadline::expired_(false);
+Deadline::Clock::time_point Deadline::end_;
+thread_local const Deadline::Budget *Deadline::current_ = nullptr;
+
+void Deadline::set(double seconds)
+{
+  end_ = Clock::now()
+      + std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(seconds));
+  isSet_ = true;
+  expired_ = false;
+  Clock::time_point end = end_;
+  std::thread([end]()
+  {
+    std::this_thread::sleep_until(end);
+    expired_ = true;
+  }).detach();
+}
+
+std::shared_ptr<Deadline::Budget> Deadline::budget(double seconds)
+{
+  std::shared_ptr<Budget> result(new Budget());
+  result->end = Clock::now()
+      + std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(seconds));
+  std::thread([result]()
+  {
+    std::unique_lock<std::mutex> lock(result->mutex);
+    result->wake.wait_until(lock, result->end, [&result]() { return result->expired.load(); });
+    result->expired = true;
+  }).detach();
+  return result;
+}
+
+double Deadline::remaining()
+{
+  double result = std::numeric_limits<double>::max();
+  Clock::time_point now = Clock::now();
+  if (isSet_)
+    result = std::chrono::duration<double>(end_ - now).count();
+  if (current_ != nullptr)
+    result = std::min(result, current_->expired ? 0.0
+        : std::chrono::duration<double>(current_->end - now).count());
+  return result;
+}
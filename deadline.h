@@ -0,0 +1,109 @@
+/**
+ * The wall-clock deadline of the whole run and of the parts of the work run on behalf of a request.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_DEADLINE_H_
+#define BOOK_EMBEDDER_DEADLINE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+/**
+ * The long loops of the strategies end early once passed() is true, so that the best drawing found so far
+ * can be returned in time. If no deadline is set, passed() is always false.
+ * passed() is only a load of a flag, so it is cheap enough for the inner loops; the flag is raised
+ * by a detached thread that sleeps until the deadline.
+ * Besides the deadline of the whole run, a thread may work under a Budget (installed by a Scope),
+ * which then counts in passed() and remaining() of that thread as well.
+ */
+class Deadline
+{
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * A deadline of its own, e.g. of one request of the server. expire() may also be called early
+   * to stop the work; it also ends the thread that waits for the deadline.
+   */
+  struct Budget
+  {
+    std::atomic<bool> expired { false };
+    Clock::time_point end;
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    void expire()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      expired = true;
+      wake.notify_all();
+    }
+  };
+
+  /**
+   * Puts the current thread under budget until the end of the scope.
+   */
+  class Scope
+  {
+   public:
+    explicit Scope(const Budget *budget)
+        : prev_(current_)
+    {
+      current_ = budget;
+    }
+
+    ~Scope()
+    {
+      current_ = prev_;
+    }
+
+    Scope(const Scope &other) = delete;
+    Scope& operator=(const Scope &other) = delete;
+
+   private:
+    const Budget *prev_;
+  };
+
+  /**
+   * Sets the deadline to seconds from now. Must be called before any other threads are started.
+   */
+  static void set(double seconds);
+
+  static bool isSet()
+  {
+    return isSet_;
+  }
+
+  /**
+   * Seconds until the deadline (negative after it); a very large number if there is no deadline.
+   */
+  static double remaining();
+
+  static bool passed()
+  {
+    return expired_.load(std::memory_order_relaxed)
+        || (current_ != nullptr && current_->expired.load(std::memory_order_relaxed));
+  }
+
+  /**
+   * A budget of seconds from now; its flag is raised by a detached thread, which keeps the budget alive
+   * until the deadline or until expire() is called, whichever comes first.
+   */
+  static std::shared_ptr<Budget> budget(double seconds);
+
+ private:
+  static thread_local const Budget *current_;
+  static bool isSet_;
+  static std::atomic<bool> expired_;
+  static Clock::time_point end_;
+};
+
+#endif
@@ -0,0 +1,62 @@
+/**
+ * Fenwick tree (binary indexed tree) used by the sweep-based crossing counters.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_FENWICK_H_
+#define BOOK_EMBEDDER_FENWICK_H_
+
+#include <cassert>
+#include <vector>
+
+/**
+ * Prefix sums over positions 0..size-1 with point updates, both in time O(log size).
+ */
+class FenwickTree
+{
+ public:
+  FenwickTree(int size)
+      : tree_(size + 1, 0)
+  {
+  }
+
+  /**
+   * Adds val to the position pos.
+   */
+  void add(int pos, int val)
+  {
+    assert(pos >= 0 && pos + 1 < static_cast<int>(tree_.size()));
+    for (int i = pos + 1; i < static_cast<int>(tree_.size()); i += (i & -i))
+      tree_[i] += val;
+  }
+
+  /**
+   * Sum of the values at positions 0..pos (inclusive). Returns 0 if pos is negative.
+   */
+  int prefixSum(int pos) const
+  {
+    int result = 0;
+    for (int i = pos + 1; i > 0; i -= (i & -i))
+      result += tree_[i];
+    return result;
+  }
+
+  /**
+   * Sum of the values at positions strictly between from and to.
+   */
+  int sumBetween(int from, int to) const
+  {
+    if (to - from < 2)
+      return 0;
+    return prefixSum(to - 1) - prefixSum(from);
+  }
+
+ private:
+  std::vector<int> tree_;
+};
+
+#endif
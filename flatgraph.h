@@ -0,0 +1,135 @@
+/**
+ * Compact (structure of arrays) representation of graphs in book-embedder.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_FLATGRAPH_H_
+#define BOOK_EMBEDDER_FLATGRAPH_H_
+
+#include <vector>
+
+#include "graph.h"
+
+/**
+ * The same information as in Graph, but without any pointers, so that a copy is just a few memcpy's.
+ * The adjacency is stored in the CSR format ordered by the current positions of the vertices,
+ * so the edges incident to the vertices at positions a..b occupy the contiguous range of slots
+ * offs[a]..offs[b+1]-1. For every slot, the edge, the position of the other end-point and the page are
+ * stored in separate arrays, so the crossing kernels only scan contiguous int arrays.
+ * Edge i has its end-points ev1[i], ev2[i] (positions) and the page ep[i]; it occupies slots slot1[i]
+ * (in the list of ev1[i]) and slot2[i] (in the list of ev2[i]).
+ */
+class FlatGraph
+{
+ public:
+  int p = 0;
+  std::vector<int> id;  ///< id[pos] is the id (the initial position) of the vertex at position pos.
+  std::vector<int> offs;  ///< n+1 offsets into the slot arrays.
+  std::vector<int> adjEdge;  ///< The edge of every slot.
+  std::vector<int> adjOther;  ///< The position of the other end-point of the edge of every slot.
+  std::vector<int> adjPage;  ///< The page of the edge of every slot.
+  std::vector<char> adjSide;  ///< 0 if the slot is slot1 of its edge, 1 if it is slot2.
+  std::vector<int> ev1, ev2, ep;
+  std::vector<int> slot1, slot2;
+
+  FlatGraph()
+  {
+  }
+
+  explicit FlatGraph(const Graph &gr)
+  {
+    loadFrom(gr);
+  }
+
+  int vertexCnt() const
+  {
+    return static_cast<int>(id.size());
+  }
+
+  int edgeCnt() const
+  {
+    return static_cast<int>(ep.size());
+  }
+
+  /**
+   * Time O(n + m).
+   */
+  void loadFrom(const Graph &gr)
+  {
+    int n = static_cast<int>(gr.v.size());
+    int m = static_cast<int>(gr.e.size());
+    p = gr.p;
+    id.resize(n);
+    for (int i = 0; i < n; i++)
+      id[i] = gr.v[i].id;
+    ev1.resize(m);
+    ev2.resize(m);
+    ep.resize(m);
+    offs.assign(n + 1, 0);
+    for (int i = 0; i < m; i++)
+    {
+      ev1[i] = gr.e[i].v1;
+      ev2[i] = gr.e[i].v2;
+      ep[i] = gr.e[i].p;
+      offs[ev1[i] + 1]++;
+      offs[ev2[i] + 1]++;
+    }
+    for (int i = 0; i < n; i++)
+      offs[i + 1] += offs[i];
+    adjEdge.resize(2 * m);
+    adjOther.resize(2 * m);
+    adjPage.resize(2 * m);
+    adjSide.resize(2 * m);
+    slot1.resize(m);
+    slot2.resize(m);
+    std::vector<int> fill(offs.begin(), offs.end() - 1);
+    for (int i = 0; i < m; i++)
+    {
+      slot1[i] = fill[ev1[i]]++;
+      slot2[i] = fill[ev2[i]]++;
+      setSlot(slot1[i], i, ev2[i], 0);
+      setSlot(slot2[i], i, ev1[i], 1);
+    }
+  }
+
+  /**
+   * Writes the drawing back to a Graph. The original contents of gr are removed.
+   * Time O(n + m).
+   */
+  void storeTo(Graph *gr) const
+  {
+    gr->p = p;
+    gr->v.clear();
+    for (int vid : id)
+      gr->v.push_back(Vertex(vid));
+    gr->e.clear();
+    for (int i = 0; i < edgeCnt(); i++)
+      gr->e.push_back(Edge(ev1[i], ev2[i], ep[i]));
+    gr->restoreNeighs();
+  }
+
+  /**
+   * Time O(1).
+   */
+  void setPage(int ed, int page)
+  {
+    ep[ed] = page;
+    adjPage[slot1[ed]] = page;
+    adjPage[slot2[ed]] = page;
+  }
+
+ private:
+  void setSlot(int s, int ed, int other, char side)
+  {
+    adjEdge[s] = ed;
+    adjOther[s] = other;
+    adjPage[s] = ep[ed];
+    adjSide[s] = side;
+  }
+};
+
+#endif
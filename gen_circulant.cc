@@ -14,6 +14,8 @@
 #include <string>
 #include <vector>
 
+#include "generators.h"
+
 #define MAXP 1000000
 #define MAXN 1000000
 
@@ -22,7 +24,8 @@ const std::string usage =
         "the number of vertices of the graph, and a comma-separated list of the edge lengths. "
         "Two vertices u,v are connected iff abs(u-v) mod n is from the list of edge lengths."
         "No spaces in the list of edge lengths.\n"
-        "E.g. \"gen_circulant 2 10 1,2,3\".\n";
+        "E.g. \"gen_circulant 2 10 1,2,3\".\n"
+        "Option --binary writes the binary format of book-embedder instead of the text.\n";
 
 void print_usage_and_exit()
 {
@@ -32,6 +35,8 @@ void print_usage_and_exit()
 
 int main(int argc, char *argv[])
 {
+  GenOptions options;
+  options.parse(&argc, argv);
   if (argc != 4)
     print_usage_and_exit();
 
@@ -59,13 +64,8 @@ int main(int argc, char *argv[])
       istr.ignore();
   }
 
-  printf("%d\n", n);
-  printf("%d\n", p);
-  for (int i = 0; i < n; i++)
-    printf("%d\n", i);
-
-  for (int i = 0; i < n; i++)
-    for (int l : lengths)
-      printf("%d %d [0]\n", i, (i + l) % n);
+  GraphSink *sink = options.makeSink();
+  Generators::circulant(n, lengths, p, sink);
+  delete sink;
   return 0;
 }
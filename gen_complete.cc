@@ -12,6 +12,8 @@
 #include <cstdlib>
 #include <string>
 
+#include "generators.h"
+
 #define MAXP 1000000
 #define MAXN 1000000
 
@@ -19,7 +21,8 @@ const std::string usage =
     "Exactly two arguments are required -- the number of the pages provided for the drawing, "
         "and the number of vertices of the graph.\n"
         "E.g. the complete graph with 10 vertices to be drawn in a book with 5 pages (there is a crossing-free drawing): "
-        "\"gen_complete 5 10\".\n";
+        "\"gen_complete 5 10\".\n"
+        "Option --binary writes the binary format of book-embedder instead of the text.\n";
 
 void print_usage_and_exit()
 {
@@ -29,6 +32,8 @@ void print_usage_and_exit()
 
 int main(int argc, char *argv[])
 {
+  GenOptions options;
+  options.parse(&argc, argv);
   if (argc != 3)
     print_usage_and_exit();
 
@@ -42,13 +47,8 @@ int main(int argc, char *argv[])
   if (n <= 0 || n > MAXN)
     print_usage_and_exit();
 
-  printf("%d\n", n);
-  printf("%d\n", p);
-  for (int i = 0; i < n; i++)
-    printf("%d\n", i);
-
-  for (int i = 0; i < n; i++)
-    for (int j = i + 1; j < n; j++)
-      printf("%d %d [0]\n", i, j);
+  GraphSink *sink = options.makeSink();
+  Generators::complete(n, p, sink);
+  delete sink;
   return 0;
 }
@@ -13,6 +13,8 @@
 #include <cstdlib>
 #include <string>
 
+#include "generators.h"
+
 #define MAXP 1000000
 #define MAXN 1000000
 
@@ -21,7 +23,8 @@ const std::string usage =
         "the number of vertices in each partition of the graph, and the number of partitions. "
         "Two vertices are connected iff they belong to different partitions.\n"
         "E.g. the complete bipartite graph with 20 vertices in total to be drawn in a book with 3 pages: "
-        "\"gen_complete_tpartite 3 10 2\".\n";
+        "\"gen_complete_tpartite 3 10 2\".\n"
+        "Option --binary writes the binary format of book-embedder instead of the text.\n";
 
 void print_usage_and_exit()
 {
@@ -31,6 +34,8 @@ void print_usage_and_exit()
 
 int main(int argc, char *argv[])
 {
+  GenOptions options;
+  options.parse(&argc, argv);
   if (argc != 4)
     print_usage_and_exit();
 
@@ -49,16 +54,11 @@ int main(int argc, char *argv[])
   if (t <= 0 || t > MAXN)
     print_usage_and_exit();
 
-  int nn = n * t;
-
-  printf("%d\n", nn);
-  printf("%d\n", p);
-  for (int i = 0; i < nn; i++)
-    printf("%d\n", i);
+  if (static_cast<long long>(n) * t > MAXN)
+    print_usage_and_exit();
 
-  for (int i = 0; i < nn; i++)
-    for (int j = i + 1; j < nn; j++)
-      if (i / n != j / n)
-        printf("%d %d [0]\n", i, j);
+  GraphSink *sink = options.makeSink();
+  Generators::completeTpartite(n, t, p, sink);
+  delete sink;
   return 0;
 }
@@ -12,6 +12,8 @@
 #include <cstdlib>
 #include <string>
 
+#include "generators.h"
+
 #define MAXP 1000000
 #define MAXD 30
 
@@ -19,7 +21,8 @@ const std::string usage =
     "Exactly two arguments are required -- the number of the pages provided for the drawing, "
         "and the number of dimensions of the hypercube. A d-dimensional hypercube has 2^d vertices.\n"
         "E.g. the 4-dimensional hypercube to be drawn in a book with 3 pages (there is a crossing-free drawing): "
-        "\"gen_hypercube 3 4\".\n";
+        "\"gen_hypercube 3 4\".\n"
+        "Option --binary writes the binary format of book-embedder instead of the text.\n";
 
 void print_usage_and_exit()
 {
@@ -29,6 +32,8 @@ void print_usage_and_exit()
 
 int main(int argc, char *argv[])
 {
+  GenOptions options;
+  options.parse(&argc, argv);
   if (argc != 3)
     print_usage_and_exit();
 
@@ -42,26 +47,8 @@ int main(int argc, char *argv[])
   if (d <= 0 || d > MAXD)
     print_usage_and_exit();
 
-  int n = (1 << d);
-
-  printf("%d\n", n);
-  printf("%d\n", p);
-
-  for (int i = 0; i < n; i++)
-    printf("%d\n", i);
-
-  for (int i = 0; i < n; i++)
-    for (int j = i + 1; j < n; j++)
-    {
-      int ixorj = (i ^ j);
-      int bits = 0;
-      while (ixorj > 0)
-      {
-        bits += (ixorj & 1);
-        ixorj >>= 1;
-      }
-      if (bits == 1)
-        printf("%d %d [0]\n", i, j);
-    }
+  GraphSink *sink = options.makeSink();
+  Generators::hypercube(d, p, sink);
+  delete sink;
   return 0;
 }
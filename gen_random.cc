@@ -13,13 +13,18 @@
 #include <cstdlib>
 #include <string>
 
+#include "generators.h"
+
 #define MAXP 1000000
 #define MAXN 1000000
 
 const std::string usage =
-    "Exactly three arguments are required -- the number of the pages provided for the drawing, "
+    "Three arguments are required -- the number of the pages provided for the drawing, "
         "the number of vertices of the graph and the probability, in percents, of each edge. "
-        "The edges are created independently.\n"
+        "The edges are created independently. "
+        "The optional fourth argument is the seed of the random generator (the current time by default).\n"
+        "Option --seed S is the same as the fourth argument; --binary writes the binary format "
+        "of book-embedder instead of the text.\n"
         "E.g. a graph with 10 vertices and edge probability 20% (will have 9 vertices on average) "
         "to be drawn in a book with 3 pages: \"gen_random 3 10 20\".\n";
 
@@ -31,7 +36,9 @@ void print_usage_and_exit()
 
 int main(int argc, char *argv[])
 {
-  if (argc != 4)
+  GenOptions options;
+  options.parse(&argc, argv);
+  if (argc != 4 && argc != 5)
     print_usage_and_exit();
 
   int p = -1;
@@ -49,18 +56,14 @@ int main(int argc, char *argv[])
   if (prob <= 0.0 || prob > 100.0)
     print_usage_and_exit();
 
-  printf("%d\n", n);
-  printf("%d\n", p);
-
-  int thr = prob * RAND_MAX / 100.0;
-
-  srand(time(nullptr));
-  for (int i = 0; i < n; i++)
-    printf("%d\n", i);
+  std::uint64_t seed = time(nullptr);
+  if (options.hasSeed)
+    seed = options.seed;
+  if (argc == 5)
+    seed = strtoull(argv[4], nullptr, 10);
 
-  for (int i = 0; i < n; i++)
-    for (int j = i + 1; j < n; j++)
-      if (rand() < thr)
-        printf("%d %d [0]\n", i, j);
+  GraphSink *sink = options.makeSink();
+  Generators::random(n, prob, seed, p, sink);
+  delete sink;
   return 0;
 }
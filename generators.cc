@@ -0,0 +1,286 @@
+/**
+ * The graph families of the gen_* programs, written to a text or a binary stream
+ * or built directly in memory.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "generators.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+
+const int maxP = 1000000;
+const int maxN = 1000000;
+const int maxD = 30;
+
+/**
+ * Splits s at every occurrence of sep.
+ */
+vector<string> split(const string &s, char sep)
+{
+  vector<string> parts;
+  std::size_t beg = 0;
+  while (true)
+  {
+    std::size_t pos = s.find(sep, beg);
+    parts.push_back(s.substr(beg, pos - beg));
+    if (pos == string::npos)
+      return parts;
+    beg = pos + 1;
+  }
+}
+
+/**
+ * The whole of s as an integer in min..max; throws invalid_argument otherwise.
+ */
+long long parseInt(const string &s, long long min, long long max, const string &what)
+{
+  char *end = nullptr;
+  long long val = strtoll(s.c_str(), &end, 10);
+  if (s.empty() || *end != '\0' || val < min || val > max)
+    throw std::invalid_argument("Bad " + what + " \"" + s + "\".");
+  return val;
+}
+
+}  // namespace
+
+void GraphBuilder::begin(int n, int p)
+{
+  gr_->p = p;
+  gr_->v.clear();
+  gr_->e.clear();
+  gr_->v.reserve(n);
+  for (int i = 0; i < n; i++)
+    gr_->v.push_back(i);
+}
+
+void TextSink::begin(int n, int p)
+{
+  putInt(n);
+  buf_[len_++] = '\n';
+  putInt(p);
+  buf_[len_++] = '\n';
+  for (int i = 0; i < n; i++)
+  {
+    if (len_ + 16 > sizeof(buf_))
+      flush();
+    putInt(i);
+    buf_[len_++] = '\n';
+  }
+}
+
+void TextSink::putInt(int val)
+{
+  char digits[12];
+  int cnt = 0;
+  unsigned uval = (val < 0 ? -static_cast<unsigned>(val) : val);
+  do
+  {
+    digits[cnt++] = '0' + uval % 10;
+    uval /= 10;
+  } while (uval > 0);
+  if (val < 0)
+    buf_[len_++] = '-';
+  while (cnt > 0)
+    buf_[len_++] = digits[--cnt];
+}
+
+void TextSink::flush()
+{
+  fwrite(buf_, 1, len_, out_);
+  len_ = 0;
+}
+
+void BinarySink::begin(int n, int p)
+{
+  n_ = n;
+  p_ = p;
+  edges_.clear();
+}
+
+void BinarySink::end()
+{
+  const char magic[8] = { 'B', 'E', 'G', 'R', 'A', 'P', 'H', '1' };
+  std::int32_t header[3] = { n_, p_, static_cast<std::int32_t>(edges_.size() / 3) };
+  fwrite(magic, 1, sizeof(magic), out_);
+  fwrite(header, sizeof(std::int32_t), 3, out_);
+  vector<std::int32_t> order(n_);
+  for (int i = 0; i < n_; i++)
+    order[i] = i;
+  fwrite(order.data(), sizeof(std::int32_t), order.size(), out_);
+  fwrite(edges_.data(), sizeof(std::int32_t), edges_.size(), out_);
+  fflush(out_);
+}
+
+void Generators::complete(int n, int p, GraphSink *sink)
+{
+  sink->begin(n, p);
+  for (int i = 0; i < n; i++)
+    for (int j = i + 1; j < n; j++)
+      sink->edge(i, j);
+  sink->end();
+}
+
+/**
+ * Partition k has the vertices k*n..(k+1)*n-1, so the neighbors of i after it are all the vertices
+ * from the next partition on.
+ */
+void Generators::completeTpartite(int n, int t, int p, GraphSink *sink)
+{
+  int nn = n * t;
+  sink->begin(nn, p);
+  for (int i = 0; i < nn; i++)
+    for (int j = (i / n + 1) * n; j < nn; j++)
+      sink->edge(i, j);
+  sink->end();
+}
+
+/**
+ * G(n, prob/100). Instead of a random number for every pair, the gap to the next edge in the sequence
+ * of the pairs is drawn from the geometric distribution, so the time is O(n + m).
+ */
+void Generators::random(int n, double prob, std::uint64_t seed, int p,
+                        GraphSink *sink)
+{
+  sink->begin(n, p);
+  double q = prob / 100.0;
+  if (q >= 1)
+  {
+    for (int i = 0; i < n; i++)
+      for (int j = i + 1; j < n; j++)
+        sink->edge(i, j);
+    sink->end();
+    return;
+  }
+  std::mt19937_64 mt(seed);
+  std::uniform_real_distribution<double> zeroOneDistrib(0, 1);
+  double logQ = std::log1p(-q);
+  // (i, j) is the current pair; when j runs over the end of row i, it continues in the next rows.
+  int i = 0;
+  long long j = 0;
+  while (i < n - 1)
+  {
+    double u = 1 - zeroOneDistrib(mt);  // in (0, 1]
+    double skip = std::floor(std::log(u) / logQ);
+    if (skip > static_cast<double>(n) * n)
+      break;
+    j += 1 + static_cast<long long>(skip);
+    while (j >= n && i < n - 1)
+    {
+      i++;
+      j = j - n + i + 1;
+    }
+    if (i >= n - 1)
+      break;
+    sink->edge(i, j);
+  }
+  sink->end();
+}
+
+void Generators::circulant(int n, const vector<int> &lengths, int p,
+                           GraphSink *sink)
+{
+  sink->begin(n, p);
+  for (int i = 0; i < n; i++)
+    for (int l : lengths)
+      sink->edge(i, (i + l) % n);
+  sink->end();
+}
+
+/**
+ * The neighbors of i after it differ from i in a single bit that is 0 in i; going through the bits from
+ * the lowest gives them in increasing order.
+ */
+void Generators::hypercube(int d, int p, GraphSink *sink)
+{
+  int n = (1 << d);
+  sink->begin(n, p);
+  for (int i = 0; i < n; i++)
+    for (int b = 0; b < d; b++)
+      if (!(i & (1 << b)))
+        sink->edge(i, i | (1 << b));
+  sink->end();
+}
+
+void Generators::generate(const string &spec, GraphSink *sink)
+{
+  vector<string> args = split(spec, ':');
+  const string &family = args[0];
+  std::size_t argCnt = args.size() - 1;
+  if (argCnt < 2)
+    throw std::invalid_argument("Too few arguments in \"" + spec + "\".");
+  int p = parseInt(args[1], 1, maxP, "number of pages");
+  if (family == "complete" && argCnt == 2)
+    complete(parseInt(args[2], 1, maxN, "number of vertices"), p, sink);
+  else if (family == "tpartite" && argCnt == 3)
+  {
+    int n = parseInt(args[2], 1, maxN, "number of vertices in a partition");
+    int t = parseInt(args[3], 1, maxN / n, "number of partitions");
+    completeTpartite(n, t, p, sink);
+  }
+  else if (family == "random" && (argCnt == 3 || argCnt == 4))
+  {
+    int n = parseInt(args[2], 1, maxN, "number of vertices");
+    char *end = nullptr;
+    double prob = strtod(args[3].c_str(), &end);
+    if (args[3].empty() || *end != '\0' || !(prob > 0.0 && prob <= 100.0))
+      throw std::invalid_argument("Bad edge probability \"" + args[3] + "\".");
+    std::uint64_t seed = time(nullptr);
+    if (argCnt == 4)
+      seed = parseInt(args[4], 0, INT64_MAX, "seed");
+    random(n, prob, seed, p, sink);
+  }
+  else if (family == "circulant" && argCnt == 3)
+  {
+    int n = parseInt(args[2], 1, maxN, "number of vertices");
+    vector<int> lengths;
+    for (const string &l : split(args[3], ','))
+      lengths.push_back(parseInt(l, 1, n - 1, "edge length"));
+    circulant(n, lengths, p, sink);
+  }
+  else if (family == "hypercube" && argCnt == 2)
+    hypercube(parseInt(args[2], 1, maxD, "number of dimensions"), p, sink);
+  else
+    throw std::invalid_argument("Unknown graph family or wrong number of arguments in \"" + spec + "\".");
+}
+
+void GenOptions::parse(int *argc, char *argv[])
+{
+  int kept = 1;
+  for (int i = 1; i < *argc; i++)
+  {
+    if (strcmp(argv[i], "--binary") == 0)
+      binary = true;
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < *argc)
+    {
+      hasSeed = true;
+      seed = strtoull(argv[++i], nullptr, 10);
+    }
+    else
+      argv[kept++] = argv[i];
+  }
+  *argc = kept;
+}
+
+GraphSink *GenOptions::makeSink() const
+{
+  if (binary)
+    return new BinarySink(stdout);
+  return new TextSink(stdout);
+}
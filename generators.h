@@ -0,0 +1,184 @@
+/**
+ * The graph families of the gen_* programs, written to a text or a binary stream
+ * or built directly in memory.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_GENERATORS_H_
+#define BOOK_EMBEDDER_GENERATORS_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+
+/**
+ * Receives a generated graph: begin with the numbers of vertices and pages, then every edge
+ * (all on page 0), then end. The vertices are 0..n-1 in this order.
+ */
+class GraphSink
+{
+ public:
+  virtual ~GraphSink()
+  {
+  }
+
+  virtual void begin(int n, int p) = 0;
+
+  virtual void edge(int u, int v) = 0;
+
+  virtual void end() = 0;
+};
+
+/**
+ * Writes the text format of the Graph Drawing 2015 challenge through a large buffer.
+ */
+class TextSink : public GraphSink
+{
+ public:
+  explicit TextSink(FILE *out)
+      : out_(out)
+  {
+  }
+
+  void begin(int n, int p);
+
+  void edge(int u, int v)
+  {
+    if (len_ + 32 > sizeof(buf_))
+      flush();
+    putInt(u);
+    buf_[len_++] = ' ';
+    putInt(v);
+    buf_[len_++] = ' ';
+    buf_[len_++] = '[';
+    buf_[len_++] = '0';
+    buf_[len_++] = ']';
+    buf_[len_++] = '\n';
+  }
+
+  void end()
+  {
+    flush();
+  }
+
+ private:
+  FILE *out_;
+  char buf_[1 << 16];
+  std::size_t len_ = 0;
+
+  void putInt(int val);
+
+  void flush();
+};
+
+/**
+ * Writes the binary format of Loader. The number of edges is in the header, so the edges are kept
+ * in memory (12 bytes per edge) until end.
+ */
+class BinarySink : public GraphSink
+{
+ public:
+  explicit BinarySink(FILE *out)
+      : out_(out)
+  {
+  }
+
+  void begin(int n, int p);
+
+  void edge(int u, int v)
+  {
+    edges_.push_back(u);
+    edges_.push_back(v);
+    edges_.push_back(0);
+  }
+
+  void end();
+
+ private:
+  FILE *out_;
+  std::int32_t n_ = 0;
+  std::int32_t p_ = 0;
+  std::vector<std::int32_t> edges_;
+};
+
+/**
+ * Builds the generated graph in gr (the original contents are removed), with the vertices in the order
+ * of their ids and all edges on page 0, as if the text output were loaded by Loader.
+ */
+class GraphBuilder : public GraphSink
+{
+ public:
+  explicit GraphBuilder(Graph *gr)
+      : gr_(gr)
+  {
+  }
+
+  void begin(int n, int p);
+
+  void edge(int u, int v)
+  {
+    gr_->e.push_back(Edge(u, v, 0));
+  }
+
+  void end()
+  {
+    gr_->restoreNeighs();
+  }
+
+ private:
+  Graph *gr_;
+};
+
+/**
+ * The generators take time linear in the size of the output. The edges {u,v} have u < v (except for
+ * the circulant graphs) and are ordered by u and then by v.
+ */
+class Generators
+{
+ public:
+  static void complete(int n, int p, GraphSink *sink);
+
+  static void completeTpartite(int n, int t, int p, GraphSink *sink);
+
+  static void random(int n, double prob, std::uint64_t seed, int p, GraphSink *sink);
+
+  static void circulant(int n, const std::vector<int> &lengths, int p, GraphSink *sink);
+
+  static void hypercube(int d, int p, GraphSink *sink);
+
+  /**
+   * Runs the generator given by spec, which is the name of the family followed by the arguments
+   * of its gen_* program, all separated by colons:
+   * complete:P:N, tpartite:P:N:T, random:P:N:PROB[:SEED], circulant:P:N:L1,L2,... and hypercube:P:D.
+   * The random graph without SEED is seeded by the current time.
+   * Throws invalid_argument if spec is not valid.
+   */
+  static void generate(const std::string &spec, GraphSink *sink);
+};
+
+/**
+ * Removes the options common to all the gen_* programs from the arguments: "--seed S" (for the random
+ * generators; the current time by default) and "--binary" (write the binary format instead of the text).
+ */
+struct GenOptions
+{
+  bool binary = false;
+  bool hasSeed = false;
+  std::uint64_t seed = 0;
+
+  void parse(int *argc, char *argv[]);
+
+  /**
+   * Returns the sink for the standard output in the chosen format; to be deleted by the caller.
+   */
+  GraphSink *makeSink() const;
+};
+
+#endif
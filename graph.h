@@ -13,13 +13,14 @@
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <utility>
 #include <vector>
 
 class Edge
 {
  public:
   int v1, v2;  ///< The current positions of the endpoints (may differ from the vertex ids)
-  int p = 0;  ///< The page, where the edge currently is (numbering starts at 0)
+  int p = 0;  ///< The page, where the edge currently is (numbering starts at 0). Change only by Graph::setPage!
   int cr = 0;  ///< Number of crossings. Used only sometimes.
   Edge(int v1_in, int v2_in, int p_in)
       : v1(v1_in),
@@ -49,6 +50,30 @@ class EdgeLengthComparer
   }
 };
 
+/**
+ * A range of edges of one page in the page index of a vertex.
+ */
+class PageEdges
+{
+ public:
+  PageEdges(Edge * const *b, Edge * const *e)
+      : b_(b),
+        e_(e)
+  {
+  }
+  Edge * const *begin() const
+  {
+    return b_;
+  }
+  Edge * const *end() const
+  {
+    return e_;
+  }
+ private:
+  Edge * const *b_;
+  Edge * const *e_;
+};
+
 /**
  * The vertex with an id, which is the initial position.
  * The current position is the position within the vector in Graph.
@@ -58,10 +83,55 @@ class Vertex
  public:
   int id;  ///< The initial position.
   std::vector<Edge *> neighs;
+  std::vector<Edge *> byPage;  ///< The same edges as in neighs, grouped by page (unassigned page -1 first).
+  std::vector<int> pageBeg;  ///< Edges on page p are byPage[pageBeg[p+1]] .. byPage[pageBeg[p+2]-1].
   Vertex(int id_in)
       : id(id_in)
   {
   }
+
+  /**
+   * The incident edges on page p (p may be -1).
+   */
+  PageEdges onPage(int p) const
+  {
+    return PageEdges(byPage.data() + pageBeg[p + 1], byPage.data() + pageBeg[p + 2]);
+  }
+
+  /**
+   * The incident edges with assigned pages.
+   */
+  PageEdges onAllPages() const
+  {
+    return PageEdges(byPage.data() + pageBeg[1], byPage.data() + byPage.size());
+  }
+
+  /**
+   * Moves ed from the bucket of page from to the bucket of page to.
+   * The edge is swapped over the boundaries of the buckets in between.
+   * Time O(|from - to| + number of edges of the vertex on page from).
+   */
+  void moveInPageIndex(Edge *ed, int from, int to)
+  {
+    int b = from + 1;
+    int i = pageBeg[b];
+    while (byPage[i] != ed)
+      i++;
+    assert(i < pageBeg[b + 1]);
+    while (b < to + 1)
+    {
+      // swap to the end of the bucket, which then becomes the beginning of the next one
+      std::swap(byPage[i], byPage[pageBeg[b + 1] - 1]);
+      i = --pageBeg[b + 1];
+      b++;
+    }
+    while (b > to + 1)
+    {
+      std::swap(byPage[i], byPage[pageBeg[b]]);
+      i = pageBeg[b]++;
+      b--;
+    }
+  }
 };
 
 class Graph
@@ -94,18 +164,47 @@ class Graph
   }
 
   /**
-   * Fills the neighs in all the vertices based on the information in edges.
+   * Fills the neighs and the page index in all the vertices based on the information in edges.
    */
   void restoreNeighs()
   {
     for (Vertex &ver : v)
+    {
       ver.neighs.clear();
+      ver.pageBeg.assign(p + 2, 0);
+    }
     for (Edge &ed : e)
     {
+      assert(ed.p >= -1 && ed.p < p);
       v[ed.v1].neighs.push_back(&ed);
       v[ed.v2].neighs.push_back(&ed);
+      v[ed.v1].pageBeg[ed.p + 2]++;
+      v[ed.v2].pageBeg[ed.p + 2]++;
+    }
+    for (Vertex &ver : v)
+    {
+      for (int i = 1; i < p + 2; i++)
+        ver.pageBeg[i] += ver.pageBeg[i - 1];
+      ver.byPage.resize(ver.neighs.size());
+      std::vector<int> fill(ver.pageBeg.begin(), ver.pageBeg.end() - 1);
+      for (Edge *ed : ver.neighs)
+        ver.byPage[fill[ed->p + 1]++] = ed;
     }
   }
+
+  /**
+   * Changes the page of ed and updates the page index of its end-points.
+   * Time O(|ed->p - page| + number of edges on page ed->p at the end-points).
+   */
+  void setPage(Edge *ed, int page)
+  {
+    if (ed->p == page)
+      return;
+    assert(page >= -1 && page < p);
+    v[ed->v1].moveInPageIndex(ed, ed->p, page);
+    v[ed->v2].moveInPageIndex(ed, ed->p, page);
+    ed->p = page;
+  }
 };
 
 #endif
@@ -0,0 +1,74 @@
+/**
+ * Converts graphs between the text format of the Graph Drawing 2015 challenge and the binary format
+ * of book-embedder.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "graph.h"
+#include "loader.h"
+
+using std::string;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+const string usage =
+    "Exactly three arguments are required -- the direction (text2bin or bin2text), the input file "
+        "and the output file.\n"
+        "E.g. \"graph_convert text2bin graph.txt graph.bin\".\n";
+
+int main(int argc, char *argv[])
+{
+  if (argc != 4)
+  {
+    cerr << usage;
+    return 0;
+  }
+  string direction = argv[1];
+  if (direction != "text2bin" && direction != "bin2text")
+  {
+    cerr << usage;
+    return 0;
+  }
+
+  // The loaders report the size of the graph to cout.
+  std::streambuf *coutBuf = cout.rdbuf(cerr.rdbuf());
+  Graph gr;
+  try
+  {
+    Loader::loadFile(argv[2], &gr);
+  }
+  catch (std::exception &exc)
+  {
+    cerr << exc.what() << endl;
+    return 1;
+  }
+  cout.rdbuf(coutBuf);
+
+  std::ofstream output(argv[3], std::ios::binary);
+  if (!output.is_open())
+  {
+    cerr << "Cannot open " << argv[3] << endl;
+    return 1;
+  }
+  if (direction == "text2bin")
+    Loader::saveBinary(gr, output);
+  else
+    Loader::saveText(gr, output);
+  if (!output)
+  {
+    cerr << "Failed to write " << argv[3] << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -1,5 +1,6 @@
 /**
- * Functions for loading graphs in the format of the Graph Drawing 2015 challenge.
+ * Functions for loading graphs in the format of the Graph Drawing 2015 challenge
+ * and in the binary format of book-embedder.
  *
  * Program for minimizing the number of crossings in a book embedding of a given
  * graph to a given number of pages.
@@ -8,136 +9,208 @@
  * License: see the file LICENSE
  */
 
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <limits>
 #include <string>
 #include <stdexcept>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "loader.h"
 #include "tools.h"
 
 using std::string;
 using std::vector;
 using std::istream;
-using std::istringstream;
 using std::cout;
 using std::cerr;
 using std::endl;
 
-class NoMoreLinesException : public std::runtime_error
+namespace
 {
- public:
-  NoMoreLinesException(const string &msg)
-      : runtime_error(msg)
-  {
-  }
-};
 
-/**
- * Read a single non-empty line from input. Empty (whitespace-only) lines are skipped.
- * Throws NoMoreLinesException when end of file reached and runtime_error in case of
- * a failure while reading from input.
- */
-string Loader::mygetline(istream &input)
+const char binaryMagic[8] = { 'B', 'E', 'G', 'R', 'A', 'P', 'H', '1' };
+
+void writeInt32(std::ostream &output, std::int32_t val)
 {
-  bool line_read = false;
-  string line;
-  while (!line_read)
-  {
-    if (input.eof())
-      throw NoMoreLinesException("Failed to read a line from the input.");
-    std::getline(input, line);
-    if (!input.eof() && input.fail())
-      throw std::runtime_error("Failure occurred while trying to read a line.");
-    line = line.substr(0, line.find_first_of("\n\r#"));
-    if (line.find_first_not_of(" \t") != line.npos)
-      line_read = true;
-  }
-  return line;
+  output.write(reinterpret_cast<const char *>(&val), sizeof(val));
 }
 
 /**
- * Reads a number from input.
- * The number may be preceded only by whitespace on the line. The rest of the line after the number is ignored.
- * Throws runtime_error in case of an error.
+ * Goes through the lines of a text in memory, skipping the comments (from '#' to the end of the line)
+ * and the lines that are empty apart from whitespace. The line numbers are counted for error messages.
  */
-int Loader::mygetnumber(istream &input)
+class LineScanner
 {
-  string line = mygetline(input);
-  istringstream istr(line);
-  int result;
-  istr >> result;
-  if (istr.fail())
-    throw std::runtime_error("Failed to parse " + line + " as a number.");
-  return result;
+ public:
+  LineScanner(const char *text, const char *end)
+      : pos_(text),
+        end_(end)
+  {
+  }
+
+  /**
+   * Moves to the next non-empty line; returns false at the end of the text.
+   * The line (without the comment and the line end) is then lineBeg..lineEnd.
+   */
+  bool next()
+  {
+    while (pos_ < end_)
+    {
+      line_++;
+      const char *eol = static_cast<const char *>(memchr(pos_, '\n', end_ - pos_));
+      if (eol == nullptr)
+        eol = end_;
+      lineBeg = pos_;
+      lineEnd = lineBeg;
+      while (lineEnd < eol && *lineEnd != '#' && *lineEnd != '\r')
+        lineEnd++;
+      pos_ = (eol < end_ ? eol + 1 : end_);
+      cur_ = lineBeg;
+      skipSpace();
+      if (cur_ < lineEnd)
+        return true;
+    }
+    return false;
+  }
+
+  void nextOrFail(const char *what)
+  {
+    if (!next())
+      fail(string("Unexpected end of the input, expected ") + what + ".");
+  }
+
+  /**
+   * Parses an integer at the current position of the line (after optional whitespace).
+   */
+  int number(const char *what)
+  {
+    skipSpace();
+    bool negative = false;
+    if (cur_ < lineEnd && (*cur_ == '-' || *cur_ == '+'))
+      negative = (*cur_++ == '-');
+    if (cur_ == lineEnd || *cur_ < '0' || *cur_ > '9')
+      fail(string("Failed to parse ") + what + " in \"" + line() + "\".");
+    long long val = 0;
+    while (cur_ < lineEnd && *cur_ >= '0' && *cur_ <= '9')
+    {
+      val = val * 10 + (*cur_++ - '0');
+      if (val > std::numeric_limits<int>::max())
+        fail(string("The ") + what + " in \"" + line() + "\" is too large.");
+    }
+    return static_cast<int>(negative ? -val : val);
+  }
+
+  void expect(char c, const char *what)
+  {
+    skipSpace();
+    if (cur_ == lineEnd || *cur_ != c)
+      fail("Failed to parse \"" + line() + "\" as an Edge: " + what);
+    cur_++;
+  }
+
+  void fail(const string &msg) const
+  {
+    throw std::runtime_error("Line " + std::to_string(line_) + ": " + msg);
+  }
+
+  const char *lineBeg = nullptr;
+  const char *lineEnd = nullptr;
+
+ private:
+  const char *pos_;
+  const char *end_;
+  const char *cur_ = nullptr;
+  int line_ = 0;
+
+  void skipSpace()
+  {
+    while (cur_ < lineEnd && (*cur_ == ' ' || *cur_ == '\t'))
+      cur_++;
+  }
+
+  string line() const
+  {
+    return string(lineBeg, lineEnd);
+  }
+};
+
 }
 
 /**
- * Reads an edge, that is, a line starting with two whitespace separated number.
- * The rest of the line after the numbers is ignored.
- * Throws runtime_error in case of an error.
+ * Load gr from input. Original contents of gr (if any) are removed.
+ * The whole input is read to memory and parsed in one pass.
+ * Throws runtime_error with the line number in case of an error.
  */
-Edge Loader::mygetedge(istream &input, vector<int> &whereIsVertex)
+void Loader::load(istream &input, Graph *gr)
 {
-  string line = mygetline(input);
-  istringstream istr(line);
-  int v1;
-  istr >> v1;
-  int v2;
-  istr >> v2;
-  char c;
-  istr >> c;
-  if (c != '[')
-    throw std::runtime_error(
-        "Failed to parse " + line + " as an Edge: missing \'[\'");
-  int page;
-  istr >> page;
-  istr >> c;
-  if (c != ']')
-    throw std::runtime_error(
-        "Failed to parse " + line + " as an Edge: missing \']\'");
-  if (istr.fail())
-    throw std::runtime_error("Failed to parse " + line + " as an Edge.");
-  return Edge(whereIsVertex[v1], whereIsVertex[v2], page);
+  vector<char> text;
+  const std::size_t chunk = 1 << 20;
+  while (input)
+  {
+    std::size_t oldSize = text.size();
+    text.resize(oldSize + chunk);
+    input.read(text.data() + oldSize, chunk);
+    text.resize(oldSize + input.gcount());
+  }
+  if (input.bad())
+    throw std::runtime_error("Failure occurred while reading the input.");
+  parseText(text.data(), text.data() + text.size(), gr);
 }
 
 /**
- * Load gr from input. Original contents of gr (if any) are removed.
+ * The vertex names are checked to be a permutation of 0..n-1, the end-points of the edges
+ * to be among them and their pages to be in [-1, p). The rest of a line after the expected numbers (and after the ']' of an edge)
+ * is ignored.
  */
-void Loader::load(istream &input, Graph *gr)
+void Loader::parseText(const char *text, const char *end, Graph *gr)
 {
-  int n = mygetnumber(input);
+  LineScanner scanner(text, end);
+  scanner.nextOrFail("the number of vertices");
+  int n = scanner.number("the number of vertices");
+  if (n < 0)
+    scanner.fail("The number of vertices is negative.");
 
   gr->v.clear();
   gr->e.clear();
   for (int i = 0; i < n; i++)
     gr->v.push_back(i);
 
-  gr->p = mygetnumber(input);
+  scanner.nextOrFail("the number of pages");
+  gr->p = scanner.number("the number of pages");
+  if (gr->p < 1)
+    scanner.fail("The number of pages is not positive.");
 
   std::vector<int> whereIsVertex(n, -1);
   for (int i = 0; i < n; i++)
   {
-    int id = mygetnumber(input);
+    scanner.nextOrFail("a vertex");
+    int id = scanner.number("a vertex");
+    if (id < 0 || id >= n || whereIsVertex[id] != -1)
+      scanner.fail("Bad or duplicate vertex " + std::to_string(id) + ".");
     whereIsVertex[id] = i;
   }
 
   // Read edges up to the end of the file.
-  while (true)
+  while (scanner.next())
   {
-    try
-    {
-      gr->e.push_back(mygetedge(input, whereIsVertex));
-    }
-    catch (NoMoreLinesException &exc)
-    {
-      break;
-    }
-    catch (std::exception &exc)
-    {
-      throw;
-    }
+    int v1 = scanner.number("the first end-point");
+    int v2 = scanner.number("the second end-point");
+    scanner.expect('[', "missing \'[\'");
+    int page = scanner.number("the page");
+    scanner.expect(']', "missing \']\'");
+    if (v1 < 0 || v1 >= n || v2 < 0 || v2 >= n)
+      scanner.fail("An end-point of the edge is not a vertex.");
+    if (page < -1 || page >= gr->p)
+      scanner.fail("Bad page " + std::to_string(page) + " of the edge.");
+    gr->e.push_back(Edge(whereIsVertex[v1], whereIsVertex[v2], page));
   }
   cout << "Loaded graph with " << gr->v.size() << " vertices and "
        << gr->e.size() << " edges." << endl;
@@ -145,3 +218,152 @@ void Loader::load(istream &input, Graph *gr)
   // Set the pointers to edges now, when the vector of all edges is filled and will not be moved.
   gr->restoreNeighs();
 }
+
+/**
+ * Load gr from a file in the binary format; the file is mapped to memory and the graph is built directly
+ * from it. Original contents of gr (if any) are removed.
+ * Throws runtime_error if the file cannot be read or is not a valid graph.
+ */
+void Loader::loadBinary(const string &filename, Graph *gr)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Cannot open " + filename + ".");
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(binaryMagic) + 12))
+  {
+    close(fd);
+    throw std::runtime_error(filename + " is too short for a binary graph.");
+  }
+  std::size_t size = st.st_size;
+  void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED)
+    throw std::runtime_error("Cannot map " + filename + " to memory.");
+  try
+  {
+    parseBinary(static_cast<const char *>(mapped), size, filename, gr);
+  }
+  catch (...)
+  {
+    munmap(mapped, size);
+    throw;
+  }
+  munmap(mapped, size);
+}
+
+/**
+ * Load gr from the contents of a file in either of the formats, which are in memory.
+ * Original contents of gr (if any) are removed.
+ * Throws runtime_error if data is not a valid graph.
+ */
+void Loader::loadBuffer(const char *data, std::size_t size, Graph *gr)
+{
+  if (size >= sizeof(binaryMagic) && memcmp(data, binaryMagic, sizeof(binaryMagic)) == 0)
+    parseBinary(data, size, "The binary graph", gr);
+  else
+    parseText(data, data + size, gr);
+}
+
+/**
+ * Builds gr from the binary format in bytes; name is used in the error messages.
+ */
+void Loader::parseBinary(const char *bytes, std::size_t size, const string &name, Graph *gr)
+{
+  std::int32_t header[3];
+  if (size < sizeof(binaryMagic) + sizeof(header))
+    throw std::runtime_error(name + " is too short for a binary graph.");
+  memcpy(header, bytes + sizeof(binaryMagic), sizeof(header));
+  std::int64_t n = header[0];
+  std::int64_t p = header[1];
+  std::int64_t m = header[2];
+  if (memcmp(bytes, binaryMagic, sizeof(binaryMagic)) != 0)
+    throw std::runtime_error(name + " is not a binary graph.");
+  if (n < 0 || p <= 0 || m < 0
+      || size != sizeof(binaryMagic) + sizeof(header) + 4 * n + 12 * m)
+    throw std::runtime_error(name + " has a wrong size.");
+
+  const std::int32_t *order = reinterpret_cast<const std::int32_t *>(bytes
+      + sizeof(binaryMagic) + sizeof(header));
+  const std::int32_t *edges = order + n;
+  gr->p = p;
+  gr->v.clear();
+  gr->e.clear();
+  gr->v.reserve(n);
+  gr->e.reserve(m);
+  for (int i = 0; i < n; i++)
+    gr->v.push_back(i);
+  std::vector<int> whereIsVertex(n, -1);
+  for (int i = 0; i < n; i++)
+  {
+    if (order[i] < 0 || order[i] >= n || whereIsVertex[order[i]] != -1)
+      throw std::runtime_error(name + ": bad or duplicate vertex id.");
+    whereIsVertex[order[i]] = i;
+  }
+  for (std::int64_t i = 0; i < m; i++)
+  {
+    const std::int32_t *ed = edges + 3 * i;
+    if (ed[0] < 0 || ed[0] >= n || ed[1] < 0 || ed[1] >= n || ed[2] < -1 || ed[2] >= p)
+      throw std::runtime_error(name + ": bad edge.");
+    gr->e.push_back(Edge(whereIsVertex[ed[0]], whereIsVertex[ed[1]], ed[2]));
+  }
+  cout << "Loaded graph with " << gr->v.size() << " vertices and "
+       << gr->e.size() << " edges." << endl;
+
+  gr->restoreNeighs();
+}
+
+bool Loader::isBinaryFile(const string &filename)
+{
+  std::ifstream input(filename.c_str(), std::ios::binary);
+  char magic[sizeof(binaryMagic)];
+  input.read(magic, sizeof(magic));
+  return input && memcmp(magic, binaryMagic, sizeof(magic)) == 0;
+}
+
+/**
+ * Load gr from a file in either of the formats.
+ */
+void Loader::loadFile(const string &filename, Graph *gr)
+{
+  if (isBinaryFile(filename))
+  {
+    loadBinary(filename, gr);
+    return;
+  }
+  std::ifstream input(filename.c_str());
+  if (!input.is_open())
+    throw std::runtime_error("Cannot open " + filename + ".");
+  load(input, gr);
+}
+
+/**
+ * Writes gr in the text format; the vertices are named by their ids.
+ */
+void Loader::saveText(const Graph &gr, std::ostream &output)
+{
+  output << gr.v.size() << "\n" << gr.p << "\n";
+  for (const Vertex &ver : gr.v)
+    output << ver.id << "\n";
+  for (const Edge &ed : gr.e)
+    output << gr.v[ed.v1].id << " " << gr.v[ed.v2].id << " [" << ed.p << "]\n";
+}
+
+/**
+ * Writes gr in the binary format; the vertices are named by their ids.
+ */
+void Loader::saveBinary(const Graph &gr, std::ostream &output)
+{
+  output.write(binaryMagic, sizeof(binaryMagic));
+  writeInt32(output, gr.v.size());
+  writeInt32(output, gr.p);
+  writeInt32(output, gr.e.size());
+  for (const Vertex &ver : gr.v)
+    writeInt32(output, ver.id);
+  for (const Edge &ed : gr.e)
+  {
+    writeInt32(output, gr.v[ed.v1].id);
+    writeInt32(output, gr.v[ed.v2].id);
+    writeInt32(output, ed.p);
+  }
+}
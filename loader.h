@@ -1,5 +1,6 @@
 /**
- * Functions for loading graphs in the format of the Graph Drawing 2015 challenge.
+ * Functions for loading graphs in the format of the Graph Drawing 2015 challenge
+ * and in the binary format of book-embedder.
  *
  * Program for minimizing the number of crossings in a book embedding of a given
  * graph to a given number of pages.
@@ -10,22 +11,40 @@
 #ifndef BOOK_EMBEDDER_LOADER_H_
 #define BOOK_EMBEDDER_LOADER_H_
 
+#include <cstddef>
 #include <vector>
 #include <istream>
+#include <ostream>
+#include <string>
 
 #include "graph.h"
 
+/**
+ * The binary format (native byte order, 32-bit integers): the magic "BEGRAPH1", then n, p and m,
+ * the n vertex ids in the order of the drawing (as the vertex lines of the text format), and m triples
+ * (id of the first end-point, id of the second end-point, page).
+ */
 class Loader
 {
  public:
   static void load(std::istream &input, Graph *gr);
 
- private:
-  static std::string mygetline(std::istream &input);
+  static void loadBinary(const std::string &filename, Graph *gr);
+
+  static void loadFile(const std::string &filename, Graph *gr);
+
+  static void loadBuffer(const char *data, std::size_t size, Graph *gr);
 
-  static int mygetnumber(std::istream &input);
+  static bool isBinaryFile(const std::string &filename);
+
+  static void saveText(const Graph &gr, std::ostream &output);
+
+  static void saveBinary(const Graph &gr, std::ostream &output);
+
+ private:
+  static void parseText(const char *text, const char *end, Graph *gr);
 
-  static Edge mygetedge(std::istream &input, std::vector<int> &whereIsVertex);
+  static void parseBinary(const char *bytes, std::size_t size, const std::string &name, Graph *gr);
 
 };
 
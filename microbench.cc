@@ -0,0 +1,106 @@
+/**
+ * Microbenchmark of the span crossing kernels (scalar vs. AVX2) on a FlatGraph.
+ * Reads a graph in the format of the Graph Drawing 2015 challenge from the standard input,
+ * e.g. "gen_complete 4 300 | microbench".
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "flatgraph.h"
+#include "loader.h"
+#include "spankernels.h"
+#include "tools.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::vector;
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Counts crossings of every edge, rounds times.
+ */
+static long long runCount(const FlatGraph &fg, int rounds, double *time)
+{
+  long long result = 0;
+  Clock::time_point start = Clock::now();
+  for (int r = 0; r < rounds; r++)
+    for (int i = 0; i < fg.edgeCnt(); i++)
+      result += Tools::countEdgeCrossings(fg, i);
+  *time = secondsSince(start);
+  return result;
+}
+
+/**
+ * Greedy page of every edge, rounds times; each round starts from the same pages.
+ */
+static long long runGreedy(const FlatGraph &orig, int rounds, double *time)
+{
+  long long result = 0;
+  double total = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    FlatGraph fg(orig);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < fg.edgeCnt(); i++)
+      Tools::greedyEdgePage(&fg, i);
+    total += secondsSince(start);
+    for (int p : fg.ep)
+      result += p;
+  }
+  *time = total;
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  int rounds = (argc > 1 ? atoi(argv[1]) : 3);
+  Graph gr;
+  Loader::load(std::cin, &gr);
+  std::mt19937 mt(1);
+  std::uniform_int_distribution<int> pageDistrib(0, gr.p - 1);
+  for (Edge &ed : gr.e)
+    gr.setPage(&ed, pageDistrib(mt));
+  FlatGraph fg(gr);
+
+  if (!SpanKernels::avx2Available())
+    cerr << "AVX2 is not available, both columns use the scalar kernels." << endl;
+
+  cout << "kernel,scalar_s,avx2_s,speedup" << endl;
+  double tScalar, tAvx2;
+
+  SpanKernels::enableAvx2(false);
+  long long rScalar = runCount(fg, rounds, &tScalar);
+  SpanKernels::enableAvx2(true);
+  long long rAvx2 = runCount(fg, rounds, &tAvx2);
+  if (rScalar != rAvx2)
+    cerr << "countEdgeCrossings results differ!" << endl;
+  cout << "countEdgeCrossings," << tScalar << "," << tAvx2 << ","
+       << tScalar / tAvx2 << endl;
+
+  SpanKernels::enableAvx2(false);
+  rScalar = runGreedy(fg, rounds, &tScalar);
+  SpanKernels::enableAvx2(true);
+  rAvx2 = runGreedy(fg, rounds, &tAvx2);
+  if (rScalar != rAvx2)
+    cerr << "greedyEdgePage results differ!" << endl;
+  cout << "greedyEdgePage," << tScalar << "," << tAvx2 << ","
+       << tScalar / tAvx2 << endl;
+  return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * The numbers of crossings of every edge on every page, kept up to date while pages change.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "pagecostcache.h"
+#include "fenwick.h"
+#include "tools.h"
+
+using std::vector;
+
+/**
+ * Whether the cache pays off for the given number of lookups of random edges (e.g. the page moves
+ * of an annealing step), compared with a scan of the span of the edge on one page for each of them
+ * (see Tools::averageSpanScan). The build costs about p*log n per edge.
+ * Time O(n + m).
+ */
+bool PageCostCache::worthBuilding(const Graph &gr, int lookups)
+{
+  if (!fits(gr) || gr.e.empty())
+    return false;
+  double buildCost = static_cast<double>(gr.e.size()) * gr.p * std::log2(gr.v.size() + 1.0);
+  return buildCost < Tools::averageSpanScan(gr) * lookups;
+}
+
+/**
+ * Edge (a,b) with a < b crosses an edge (c,d) with c < d iff a < c < b < d or c < a < d < b.
+ * The first case is counted by a sweep over the edges by decreasing b: a Fenwick tree of every page
+ * holds the left end-points c of the edges with d > b. The second case is symmetric: by increasing a,
+ * the trees hold the right end-points d of the edges with c < a.
+ * Time O(n + m*p*log n), or O(m*p) if no edge has an assigned page.
+ */
+void PageCostCache::build(const Graph &gr)
+{
+  int n = static_cast<int>(gr.v.size());
+  int m = static_cast<int>(gr.e.size());
+  p_ = gr.p;
+  cost_.assign(static_cast<std::size_t>(m) * p_, 0);
+  bool anyAssigned = false;
+  for (const Edge &ed : gr.e)
+    anyAssigned = anyAssigned || ed.p >= 0;
+  if (!anyAssigned)
+    return;  // all costs are 0, e.g. when the edges are being placed again
+
+  // The edges sorted by the left and by the right end-points (counting sort).
+  vector<int> lo(m), hi(m);
+  vector<int> byLo(m), byHi(m);
+  vector<int> cntLo(n + 1, 0), cntHi(n + 1, 0);
+  for (int i = 0; i < m; i++)
+  {
+    lo[i] = std::min(gr.e[i].v1, gr.e[i].v2);
+    hi[i] = std::max(gr.e[i].v1, gr.e[i].v2);
+    cntLo[lo[i] + 1]++;
+    cntHi[hi[i] + 1]++;
+  }
+  for (int i = 0; i < n; i++)
+  {
+    cntLo[i + 1] += cntLo[i];
+    cntHi[i + 1] += cntHi[i];
+  }
+  for (int i = 0; i < m; i++)
+  {
+    byLo[cntLo[lo[i]]++] = i;
+    byHi[cntHi[hi[i]]++] = i;
+  }
+
+  vector<FenwickTree> trees(p_, FenwickTree(n));
+  // a < c < b < d; byHi backwards is by decreasing right end-point.
+  int inserted = m - 1;
+  for (int k = m - 1; k >= 0; k--)
+  {
+    int i = byHi[k];
+    while (inserted >= 0 && hi[byHi[inserted]] > hi[i])
+    {
+      int j = byHi[inserted--];
+      if (gr.e[j].p >= 0)
+        trees[gr.e[j].p].add(lo[j], 1);
+    }
+    for (int q = 0; q < p_; q++)
+      at(i, q) += trees[q].sumBetween(lo[i], hi[i]);
+  }
+
+  trees.assign(p_, FenwickTree(n));
+  // c < a < d < b
+  inserted = 0;
+  for (int k = 0; k < m; k++)
+  {
+    int i = byLo[k];
+    while (inserted < m && lo[byLo[inserted]] < lo[i])
+    {
+      int j = byLo[inserted++];
+      if (gr.e[j].p >= 0)
+        trees[gr.e[j].p].add(hi[j], 1);
+    }
+    for (int q = 0; q < p_; q++)
+      at(i, q) += trees[q].sumBetween(lo[i], hi[i]);
+  }
+}
+
+/**
+ * Moves ed to newPage (which may be -1) and patches the costs of the edges that interleave with it.
+ * The costs of ed itself do not change.
+ * Time O(m), but faster if ed is short.
+ */
+void PageCostCache::changePage(Graph *gr, Edge *ed, int newPage)
+{
+  int oldPage = ed->p;
+  if (oldPage == newPage)
+    return;
+  forEachInterleaving(*gr, *ed, [&](const Edge *ed2)
+  {
+    interleavingMoved(index(*gr, *ed2), oldPage, newPage);
+  });
+  gr->setPage(ed, newPage);
+}
+
+/**
+ * The same as Tools::greedyEdgePage, but the costs of the pages are looked up.
+ * Time O(p) if the page of ed does not change, otherwise O(m), but faster if ed is short.
+ * @return true iff an improvement was done.
+ */
+bool PageCostCache::greedyEdgePage(Graph *gr, Edge *ed)
+{
+  int idx = index(*gr, *ed);
+  int origPage = ed->p;
+  int best = origPage;
+
+  // Find the best page other than the original.
+  for (int pCur = 0; pCur < p_; pCur++)
+    if (pCur != origPage)
+      if (best < 0 || cost(idx, pCur) <= cost(idx, best))
+        best = pCur;
+
+  if (best < 0)  // may happen if there is only one page
+    return false;
+  changePage(gr, ed, best);
+  return (origPage < 0 || cost(idx, best) < cost(idx, origPage));
+}
@@ -0,0 +1,112 @@
+/**
+ * The numbers of crossings of every edge on every page, kept up to date while pages change.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_PAGECOSTCACHE_H_
+#define BOOK_EMBEDDER_PAGECOSTCACHE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "graph.h"
+
+/**
+ * cost(ed, q) is the number of edges on page q (other than ed) that would cross ed if ed were on
+ * page q; the edges with unassigned pages are not counted. So the best page of an edge and the change
+ * of the crossing number by moving an edge to another page are O(p) and O(1) lookups instead of
+ * scans of the span of the edge.
+ * Only the page changes done by changePage (or greedyEdgePage) keep the cache valid; a move of a vertex
+ * invalidates it and it has to be built again.
+ * The edges are identified by their index in gr.e. The cache takes m*p ints, so it is not used for
+ * graphs where that is more than maxEntries.
+ */
+class PageCostCache
+{
+ public:
+  static const std::size_t maxEntries = std::size_t(1) << 24;
+
+  static bool fits(const Graph &gr)
+  {
+    return gr.p > 0 && gr.e.size() * static_cast<std::size_t>(gr.p) <= maxEntries;
+  }
+
+  static bool worthBuilding(const Graph &gr, int lookups);
+
+  void build(const Graph &gr);
+
+  int cost(int ed, int page) const
+  {
+    return cost_[static_cast<std::size_t>(ed) * p_ + page];
+  }
+
+  int cost(const Graph &gr, const Edge &ed, int page) const
+  {
+    return cost(index(gr, ed), page);
+  }
+
+  /**
+   * Change of the crossing number if ed is moved to newPage (ed must have an assigned page).
+   * Time O(1).
+   */
+  int pageChangeDiff(const Graph &gr, const Edge &ed, int newPage) const
+  {
+    return cost(gr, ed, newPage) - cost(gr, ed, ed.p);
+  }
+
+  void changePage(Graph *gr, Edge *ed, int newPage);
+
+  /**
+   * Updates the costs of the edge ed2 after an edge interleaving with it moved from oldPage to newPage
+   * (either may be -1). Time O(1).
+   */
+  void interleavingMoved(int ed2, int oldPage, int newPage)
+  {
+    if (oldPage >= 0)
+      at(ed2, oldPage)--;
+    if (newPage >= 0)
+      at(ed2, newPage)++;
+  }
+
+  bool greedyEdgePage(Graph *gr, Edge *ed);
+
+  /**
+   * Calls f(ed2) for every edge ed2 (on any page, also unassigned) that interleaves with ed, i.e. would
+   * cross ed if they were on the same page.
+   * Time O(m), but faster if ed is short.
+   */
+  template<class F>
+  static void forEachInterleaving(const Graph &gr, const Edge &ed, F f)
+  {
+    int v1 = std::min(ed.v1, ed.v2);
+    int v2 = std::max(ed.v1, ed.v2);
+    for (int id2 = v1 + 1; id2 < v2; id2++)
+      for (Edge *ed2 : gr.v[id2].byPage)
+      {
+        int e2V2 = ed2->getOtherEnd(id2);
+        if (e2V2 < v1 || e2V2 > v2)
+          f(ed2);
+      }
+  }
+
+ private:
+  int p_ = 0;
+  std::vector<int> cost_;
+
+  static int index(const Graph &gr, const Edge &ed)
+  {
+    return static_cast<int>(&ed - &gr.e[0]);
+  }
+
+  int &at(int ed, int page)
+  {
+    return cost_[static_cast<std::size_t>(ed) * p_ + page];
+  }
+};
+
+#endif
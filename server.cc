@@ -0,0 +1,420 @@
+/**
+ * The solver as a daemon serving the requests of clients over a Unix domain socket.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "bestfound.h"
+#include "deadline.h"
+#include "loader.h"
+#include "strategies.h"
+#include "tools.h"
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace
+{
+
+const std::size_t maxHeaderLength = 256;
+const std::size_t maxRequestBytes = std::size_t(1) << 30;
+const std::size_t readChunkBytes = std::size_t(1) << 20;
+const double maxSeconds = 1e6;
+
+/**
+ * Counts the tasks of one request in the shared pool, so that the request can wait just for its own tasks.
+ */
+class TaskGroup
+{
+ public:
+  void add()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_++;
+  }
+
+  void done()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0)
+      allDone_.notify_all();
+  }
+
+  /**
+   * Returns false if some of the tasks are still running or waiting at the time end.
+   */
+  bool waitUntil(Deadline::Clock::time_point end)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return allDone_.wait_until(lock, end, [this]()
+    { return pending_ == 0;});
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable allDone_;
+  int pending_ = 0;
+};
+
+}  // namespace
+
+/**
+ * The socket of one client. The replies may be sent from the writer thread of BestFound and from
+ * the thread of the client, so sending is serialized. Once the client is gone, nothing more is sent.
+ * The socket is closed when the client thread and the last task of its requests are done with it.
+ */
+class Server::Connection
+{
+ public:
+  explicit Connection(int fd)
+      : fd_(fd)
+  {
+  }
+
+  ~Connection()
+  {
+    close(fd_);
+  }
+
+  /**
+   * Reads a line of at most maxHeaderLength characters without the '\n'. Returns false at the end
+   * of the input, on an error or if the line is too long.
+   */
+  bool readLine(string *line)
+  {
+    line->clear();
+    char c;
+    while (recv(fd_, &c, 1, 0) == 1)
+    {
+      if (c == '\n')
+        return true;
+      if (line->size() >= maxHeaderLength)
+        return false;
+      line->push_back(c);
+    }
+    return false;
+  }
+
+  /**
+   * Reads exactly size bytes into data. The buffer grows by at most readChunkBytes ahead of the bytes
+   * that have arrived, so a client cannot make the server allocate more than it actually sends.
+   * Returns false at the end of the input or on an error.
+   */
+  bool readBytes(std::size_t size, vector<char> *data)
+  {
+    data->clear();
+    while (data->size() < size)
+    {
+      std::size_t done = data->size();
+      data->resize(done + std::min(size - done, readChunkBytes));
+      std::size_t filled = done;
+      while (filled < data->size())
+      {
+        ssize_t got = recv(fd_, data->data() + filled, data->size() - filled, 0);
+        if (got < 0 && errno == EINTR)
+          continue;
+        if (got <= 0)
+          return false;
+        filled += got;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Returns false if the client is gone.
+   */
+  bool send(const string &message)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const char *data = message.data();
+    std::size_t size = message.size();
+    while (size > 0 && !broken_)
+    {
+      ssize_t sent = ::send(fd_, data, size, MSG_NOSIGNAL);
+      if (sent < 0 && errno == EINTR)
+        continue;
+      if (sent <= 0)
+        broken_ = true;
+      else
+      {
+        data += sent;
+        size -= sent;
+      }
+    }
+    return !broken_;
+  }
+
+  bool sendGraph(const char *kind, const Graph &g, int cr)
+  {
+    std::ostringstream text;
+    Loader::saveText(g, text);
+    string body = text.str();
+    return send(string(kind) + " " + std::to_string(cr) + " " + std::to_string(body.size())
+        + "\n" + body);
+  }
+
+ private:
+  int fd_;
+  std::mutex mutex_;
+  bool broken_ = false;
+};
+
+Server::Server(const string &socketPath, int threadCnt)
+    : socketPath_(socketPath),
+      pool_(threadCnt)
+{
+}
+
+/**
+ * Waits for the threads of the clients, which use the pool.
+ */
+Server::~Server()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  clientsDone_.wait(lock, [this]()
+  { return clientCnt_ == 0;});
+}
+
+int Server::run()
+{
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (socketPath_.size() >= sizeof(addr.sun_path))
+  {
+    cerr << "The socket path " << socketPath_ << " is too long." << endl;
+    return 1;
+  }
+  strcpy(addr.sun_path, socketPath_.c_str());
+
+  // A socket left by a previous run is replaced, any other file is not.
+  struct stat st;
+  if (lstat(socketPath_.c_str(), &st) == 0)
+  {
+    if (!S_ISSOCK(st.st_mode))
+    {
+      cerr << socketPath_ << " exists and is not a socket." << endl;
+      return 1;
+    }
+    unlink(socketPath_.c_str());
+  }
+
+  int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0
+      || listen(listenFd, 16) != 0)
+  {
+    cerr << "Cannot listen on " << socketPath_ << ": " << strerror(errno) << endl;
+    if (listenFd >= 0)
+      close(listenFd);
+    return 1;
+  }
+  cout << "Serving on " << socketPath_ << " with " << pool_.threadCnt() << " threads." << endl;
+
+  while (true)
+  {
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      cerr << "Cannot accept a client: " << strerror(errno) << endl;
+      close(listenFd);
+      return 1;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      clientCnt_++;
+    }
+    std::thread([this, fd]()
+    {
+      serveClient(fd);
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--clientCnt_ == 0)
+        clientsDone_.notify_all();
+    }).detach();
+  }
+}
+
+/**
+ * Serves the requests of one client until it closes the connection or sends a bad request.
+ */
+void Server::serveClient(int fd)
+{
+  std::shared_ptr<Connection> conn(new Connection(fd));
+  string header;
+  while (conn->readLine(&header))
+  {
+    std::istringstream fields(header);
+    string command;
+    double seconds = 0;
+    std::size_t bytes = 0;
+    string rest;
+    if (!(fields >> command >> seconds >> bytes) || (fields >> rest) || command != "SOLVE"
+        || !(seconds > 0 && seconds <= maxSeconds) || bytes > maxRequestBytes)
+    {
+      conn->send("ERROR Expected \"SOLVE seconds bytes\".\n");
+      return;
+    }
+    vector<char> data;
+    if (!conn->readBytes(bytes, &data))
+      return;
+    Graph gr;
+    try
+    {
+      Loader::loadBuffer(data.data(), bytes, &gr);
+    }
+    catch (std::exception &exc)
+    {
+      conn->send(string("ERROR ") + exc.what() + "\n");
+      return;
+    }
+    vector<char>().swap(data);
+    if (!solve(conn, &gr, seconds))
+      return;
+  }
+}
+
+/**
+ * The state of one request; shared by the thread of the client and the tasks of the request, so that
+ * the tasks still running at the deadline may finish after the result has been sent.
+ * After the reply, the improvements are not sent anymore.
+ */
+struct Server::Request
+{
+  Graph origGr;
+  std::shared_ptr<Deadline::Budget> budget;
+  std::shared_ptr<Connection> conn;
+  std::mutex replyMutex;
+  bool replied = false;  ///< Guarded by replyMutex.
+  // The writer of best may still call the listener, which uses the members above, while it stops.
+  std::unique_ptr<BestFound> best;
+  TaskGroup group;
+
+  ~Request()
+  {
+    best.reset();  // before any other member, whatever their order
+  }
+};
+
+/**
+ * The schedule of --time-limit within the budget of the request: GreedyBB and BBGreedy, then waves
+ * of restarts (one per thread of the pool), each annealing with a quarter of the remaining time;
+ * every fifth restart starts from the best drawing and the others from a random vertex order.
+ * The result is sent at the deadline even if some tasks of the request are still running or waiting
+ * for a thread. If the client goes away, the budget is cut short.
+ * Returns false if the best drawing failed the verification; it is answered by ERROR instead.
+ */
+bool Server::solve(std::shared_ptr<Connection> conn, Graph *gr, double seconds)
+{
+  const double minRemaining = 0.1;
+  std::shared_ptr<Request> req(new Request());
+  req->origGr.loadFrom(*gr);
+  req->budget = Deadline::budget(seconds);
+  req->conn = conn;
+  Request *r = req.get();
+  req->best.reset(new BestFound("", *gr, [r](const Graph &g, int cr)
+  {
+    std::lock_guard<std::mutex> lock(r->replyMutex);
+    if (!r->replied && !r->conn->sendGraph("BEST", g, cr))
+      r->budget->expire();
+  }));
+  Deadline::Scope scope(req->budget.get());
+
+  auto submit = [this, req](std::function<void(Request *)> task)
+  {
+    req->group.add();
+    pool_.submit([req, task]()
+    {
+      Deadline::Scope taskScope(req->budget.get());
+      if (!Deadline::passed())
+        task(req.get());
+      req->group.done();
+    });
+  };
+
+  submit([](Request *r)
+  {
+    Graph gr(r->origGr);
+    r->best->testIfBest(gr, Strategies::GreedyBB(&gr, r->best.get()));
+  });
+  submit([](Request *r)
+  {
+    Graph gr(r->origGr);
+    r->best->testIfBest(gr, Strategies::BBGreedy(&gr, r->best.get()));
+  });
+  bool inTime = req->group.waitUntil(req->budget->end);
+
+  std::random_device rd;
+  std::mt19937 seedGen(rd());
+  int restart = 0;
+  while (inTime && Deadline::remaining() > minRemaining)
+  {
+    double annealSeconds = Deadline::remaining() / 4;
+    for (int k = 0; k < pool_.threadCnt(); k++, restart++)
+    {
+      std::uint32_t seed = seedGen();
+      bool fromBest = (restart % 5 == 4);
+      submit([seed, fromBest, annealSeconds](Request *r)
+      {
+        std::mt19937 mt(seed);
+        Graph graphSA;
+        if (fromBest)
+          r->best->copyGraph(&graphSA);
+        else
+        {
+          graphSA.loadFrom(r->origGr);
+          Strategies::randomRestart(&graphSA, mt);
+        }
+        const double t0[2] = { 64, 8 };
+        for (double t : t0)
+          r->best->testIfBest(graphSA, Strategies::simAnneal(&graphSA, t, r->best.get(), mt,
+                                                             annealSeconds));
+      });
+    }
+    inTime = req->group.waitUntil(req->budget->end);
+  }
+
+  req->budget->expire();
+  req->best->flush();
+  std::lock_guard<std::mutex> lock(req->replyMutex);
+  req->replied = true;
+  string error = req->best->error();
+  if (error != "")
+  {
+    conn->send("ERROR The best drawing failed the verification: " + error + "\n");
+    return false;
+  }
+  Graph result;
+  req->best->copyGraph(&result);
+  int cr = Tools::countCrossingNumberFast(result);
+  conn->sendGraph("RESULT", result, cr);
+  cout << "Served a graph with " << result.v.size() << " vertices and " << result.e.size()
+       << " edges: " << cr << " crossings." << endl;
+  return true;
+}
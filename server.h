@@ -0,0 +1,71 @@
+/**
+ * The solver as a daemon serving the requests of clients over a Unix domain socket.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_SERVER_H_
+#define BOOK_EMBEDDER_SERVER_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "graph.h"
+#include "threadpool.h"
+
+/**
+ * A client sends one or more requests over its connection, each of them the line
+ *   SOLVE seconds bytes
+ * followed by bytes bytes of the graph in the text format or in the binary format of Loader.
+ * The server answers with the lines
+ *   BEST crossings bytes
+ * each followed by bytes bytes of an improved drawing in the text format (as BestFound writes it
+ * to the file; a drawing superseded before it is sent is skipped), and finally
+ *   RESULT crossings bytes
+ * followed by the best drawing found within the seconds. A bad request (or a best drawing that fails
+ * the verification) is answered by the line
+ *   ERROR message
+ * and the connection is closed.
+ * The requests of all the clients share one pool of worker threads, which stays warm between them.
+ * Every client has its own thread waiting for its requests, so the clients are served concurrently.
+ * The pool takes the tasks in the order of submission, so that a busy request does not hold back
+ * the tasks of an earlier one; a task that starts after the deadline of its request is skipped,
+ * and the result is sent at the deadline without waiting for the tasks still running.
+ */
+class Server
+{
+ public:
+  Server(const std::string &socketPath, int threadCnt);
+
+  ~Server();
+
+  Server(const Server &other) = delete;
+  Server& operator=(const Server &other) = delete;
+
+  /**
+   * Listens on the socket and serves the clients. Returns only if the socket cannot be set up
+   * or accepting fails, with the exit status.
+   */
+  int run();
+
+ private:
+  class Connection;
+  struct Request;
+
+  std::string socketPath_;
+  ThreadPool pool_;
+  std::mutex mutex_;
+  std::condition_variable clientsDone_;
+  int clientCnt_ = 0;  ///< Connections being served; guarded by mutex_.
+
+  void serveClient(int fd);
+
+  bool solve(std::shared_ptr<Connection> conn, Graph *gr, double seconds);
+};
+
+#endif
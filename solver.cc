@@ -1,13 +1,26 @@
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <random>
+#include <stdexcept>
 
+#include "checkpoint.h"
+#include "deadline.h"
+#include "generators.h"
 #include "graph.h"
 #include "loader.h"
+#include "server.h"
 #include "bestfound.h"
+#include "strategies.h"
+#include "stats.h"
+#include "tempering.h"
+#include "threadpool.h"
 #include "tools.h"
 
 using std::string;
@@ -16,274 +29,536 @@ using std::cout;
 using std::cerr;
 using std::endl;
 
-std::random_device rd;
-std::mt19937 mt(rd());
+const string usage =
+    "Usage: solver [--input FILE | --generate SPEC] [--threads N] [--eval-threads N] [--tempering K] [--time-limit SEC]\n"
+        "              [--stats FILE [--stats-interval SEC]]\n"
+        "              [--checkpoint FILE [--checkpoint-interval SEC] [--resume]] output_filename\n"
+        "       solver --batch MANIFEST [--threads N] [--eval-threads N] [--stats FILE [--stats-interval SEC]]\n"
+        "       solver --serve SOCKET [--threads N] [--eval-threads N] [--stats FILE [--stats-interval SEC]]\n"
+        "By default, the graph is read from the standard input.\n"
+        "--input FILE  read the graph from FILE instead, either in the text format or in the binary\n"
+        "              format made by graph_convert (which is loaded without parsing).\n"
+        "--generate SPEC  build the graph in memory by the generator of a gen_* program;\n"
+        "              SPEC is the family and the arguments of the program separated by colons:\n"
+        "              complete:P:N, tpartite:P:N:T, random:P:N:PROB[:SEED], circulant:P:N:L1,L2,...\n"
+        "              or hypercube:P:D (e.g. --generate circulant:2:60:1,3,7).\n"
+        "--threads N   run the starting strategies and the restarts of simulated annealing\n"
+        "              in parallel on N threads (default 1).\n"
+        "--eval-threads N  split the whole-graph crossing counts (including the verification\n"
+        "              of the written drawings) among N threads (default 1).\n"
+        "--tempering K instead of the restarts, run parallel tempering with K replicas\n"
+        "              from the better of GreedyBB and BBGreedy.\n"
+        "--time-limit SEC  stop after SEC seconds (the best drawing is in the output file);\n"
+        "              the annealing schedules and the number of restarts are fitted to the time.\n"
+        "--stats FILE  write the times of the phases and the counts of the annealing moves\n"
+        "              as JSON to FILE at exit (and every SEC seconds with --stats-interval).\n"
+        "--checkpoint FILE  save the state of the restarts to FILE every SEC seconds (default 60);\n"
+        "              with --resume, continue from the state saved in FILE. Not available\n"
+        "              together with --tempering or --time-limit.\n"
+        "--batch MANIFEST  solve all the instances listed in MANIFEST, one pair \"input_file output_file\"\n"
+        "              per line (empty lines and lines starting with '#' are skipped), on a shared\n"
+        "              work-stealing pool of N threads; reports the throughput at the end.\n"
+        "--serve SOCKET  run as a daemon solving the graphs sent by clients over the Unix domain\n"
+        "              socket SOCKET on a pool of N threads; a request is the line \"SOLVE seconds bytes\"\n"
+        "              and the graph in either format; the improved drawings are sent back as they are\n"
+        "              found (see server.h).\n";
 
-void BaurBrandes(Graph *gr, BestFound *best)
+/**
+ * Reports the result after the best drawing is written. Returns the exit status of the solver,
+ * which is 1 if the best drawing failed the verification (and so was not written).
+ */
+int finishRun(BestFound *best)
 {
-  int n = static_cast<int>(gr->v.size());
-  bool improved = true;
-  while (improved)
+  cout << "Result is: " << best->val() << endl;
+  best->flush();
+  Stats::finish();
+  if (best->error() != "")
   {
-    improved = false;
-    for (int i = 0; i < n; i++)
-    {
-      int bestPos;
-      int change = Tools::findBestPositionForVertex(*gr, i, &bestPos);
-      if (change < 0)
-      {
-        Tools::moveVertex(gr, i, bestPos);
-        Tools::greedyAtVertex(gr, bestPos);
-        improved = true;
-      }
-    }
-    if (improved)
-      best->testIfBest(*gr, -1);
+    cerr << "The best drawing was not written: " << best->error() << endl;
+    return 1;
   }
+  return 0;
 }
 
-int BBGreedy(Graph *gr, BestFound *best)
+/**
+ * One round of the restarts: the simulated annealing with high initial temperature,
+ * followed by another with a lower initial temperature.
+ * If seconds is positive, each of the two annealings takes about that long.
+ * If cp is not null, the state of the round is saved to it as the state of the task; the round continues
+ * from the state from if it is not null.
+ */
+void annealRound(Graph *graphSA, BestFound *best, std::mt19937 &mt,
+                 double seconds = 0, Checkpoint *cp = nullptr, int task = 0,
+                 const Checkpoint::TaskState *from = nullptr)
 {
-  while (true)
+  const double t0[2] = { 64, 8 };
+  for (int stage = 1; stage <= 2; stage++)
   {
-    int oldCr = Tools::countCrossingNumber(*gr);
-    BaurBrandes(gr, best);
-    int newCr = Tools::countCrossingNumber(*gr);
-
-    best->testIfBest(*gr, newCr);
-
-    Tools::greedyPages(gr);
-    newCr = Tools::countCrossingNumber(*gr);
-    best->testIfBest(*gr, newCr);
-    newCr = Tools::restartEdges(gr, newCr, Tools::lenPages);
-    newCr = Tools::restartEdges(gr, newCr, Tools::greedyPages);
-
-    if (newCr == oldCr)
-      break;
-    best->testIfBest(*gr, newCr);
+    if (from != nullptr && stage < from->stage)
+      continue;
+    AnnealResume resume;
+    if (from != nullptr && stage == from->stage)
+    {
+      resume.step = from->step;
+      resume.localBestVal = from->localBestVal;
+      if (resume.localBestVal >= 0)
+        cp->restoreGraph(from->localBestIds, from->localBestPages,
+                         &resume.localBest);
+    }
+    if (cp != nullptr)
+      resume.save = [&](int step, const Graph &gr, const BestFound &localBest)
+      {
+        cp->update(task, stage, step, gr, mt, localBest, *best);
+      };
+    int valSA = Strategies::simAnneal(graphSA, t0[stage - 1], best, mt,
+                                      seconds, &resume);
+    best->testIfBest(*graphSA, valSA);
   }
-  int finalCr = Tools::countCrossingNumber(*gr);
-  cout << endl << "BBGreedy: " << finalCr << endl;
-  return finalCr;
 }
 
-int GreedyBB(Graph *gr, BestFound *best)
+/**
+ * The schedule used with a time limit: GreedyBB and BBGreedy, then waves of threadCnt restarts
+ * until the deadline. Every annealing of a wave gets a quarter of the remaining time, so a wave takes
+ * at most half of it; the later waves are shorter. As in the default schedule, every fifth restart
+ * starts from the best drawing found so far and the others from a random vertex order.
+ */
+void runUntilDeadline(const Graph &origGr, BestFound *best, int threadCnt,
+                      std::mt19937 &seedGen)
 {
-  while (true)
+  const double minRemaining = 0.1;
+  ThreadPool pool(threadCnt);
+  pool.submit([&]()
   {
-    int oldCr = Tools::countCrossingNumber(*gr);
-    Tools::greedyPages(gr);
-    int newCr = Tools::countCrossingNumber(*gr);
-    best->testIfBest(*gr, newCr);
+    Graph gr(origGr);
+    best->testIfBest(gr, Strategies::GreedyBB(&gr, best));
+  });
+  pool.submit([&]()
+  {
+    Graph gr(origGr);
+    best->testIfBest(gr, Strategies::BBGreedy(&gr, best));
+  });
+  pool.wait();
 
-    newCr = Tools::restartEdges(gr, newCr, Tools::lenPages);
-    newCr = Tools::restartEdges(gr, newCr, Tools::greedyPages);
-    best->testIfBest(*gr, newCr);
+  int restart = 0;
+  while (Deadline::remaining() > minRemaining)
+  {
+    double seconds = Deadline::remaining() / 4;
+    for (int k = 0; k < threadCnt; k++, restart++)
+    {
+      std::uint32_t seed = seedGen();
+      bool fromBest = (restart % 5 == 4);
+      pool.submit([&origGr, best, seed, fromBest, seconds]()
+      {
+        std::mt19937 mt(seed);
+        Graph graphSA;
+        if (fromBest)
+          best->copyGraph(&graphSA);
+        else
+        {
+          graphSA.loadFrom(origGr);
+          Strategies::randomRestart(&graphSA, mt);
+        }
+        cout << "---------------------------------------" << endl;
+        annealRound(&graphSA, best, mt, seconds);
+      });
+    }
+    pool.wait();
+  }
+}
 
-    BaurBrandes(gr, best);
-    newCr = Tools::countCrossingNumber(*gr);
-    if (newCr == oldCr)
-      break;
+/**
+ * One instance of the batch mode; the graph and the best drawing are kept only while the instance
+ * is being solved.
+ */
+struct BatchInstance
+{
+  string input;
+  string output;
+  std::uint32_t seeds[5];
+  std::unique_ptr<Graph> origGr;
+  std::unique_ptr<BestFound> best;
+  std::atomic<int> restartsLeft { 0 };
+  std::chrono::steady_clock::time_point start;
+};
 
-    best->testIfBest(*gr, newCr);
+/**
+ * Reads the pairs of the input and the output filenames. Returns false if a line is not a pair.
+ */
+bool readManifest(const string &filename, vector<std::unique_ptr<BatchInstance> > *instances)
+{
+  std::ifstream manifest(filename.c_str());
+  if (!manifest.is_open())
+  {
+    cerr << "Cannot open " << filename << endl;
+    return false;
+  }
+  string line;
+  for (int lineNo = 1; std::getline(manifest, line); lineNo++)
+  {
+    std::istringstream fields(line);
+    std::unique_ptr<BatchInstance> inst(new BatchInstance());
+    string rest;
+    if (!(fields >> inst->input))
+      continue;
+    if (inst->input[0] == '#')
+      continue;
+    if (!(fields >> inst->output) || (fields >> rest))
+    {
+      cerr << filename << ", line " << lineNo << ": expected \"input_file output_file\"." << endl;
+      return false;
+    }
+    instances->push_back(std::move(inst));
   }
-  int finalCr = Tools::countCrossingNumber(*gr);
-  cout << endl << "GreedyBB: " << finalCr << endl;
-  return finalCr;
+  return true;
 }
 
-int simAnneal(Graph *gr, double t0, BestFound *best)
+/**
+ * The batch mode. Every instance runs the default schedule with five restarts: GreedyBB, BBGreedy
+ * and two random vertex orders, each followed by annealRound, and finally annealRound from the best
+ * drawing. Loading an instance is a task of the pool, which then submits the four restarts; the
+ * restart that finishes last submits the final one. The new tasks go to the deque of the worker
+ * that submits them, so a worker mostly stays with its instance, while the idle workers steal
+ * the restarts of the remaining instances.
+ */
+int runBatch(const string &manifestFilename, int threadCnt, std::mt19937 &seedGen)
 {
-//  double t = t0;
-  double t1 = 0.2;
-  int endIter = 1000;
-  int begIter = endIter / 50;
-//  double alpha = 0.999;
-  int m = gr->e.size();
-  int n = gr->v.size();
-  std::uniform_int_distribution<int> vertexDistrib(0, n - 1);
-  std::uniform_int_distribution<int> edgeDistrib(0, m - 1);
-  std::uniform_int_distribution<int> pageDistrib(0, gr->p - 2);
-  std::uniform_real_distribution<double> zeroOneDistrib(0, 1);
+  typedef std::chrono::steady_clock Clock;
+  vector<std::unique_ptr<BatchInstance> > instances;
+  if (!readManifest(manifestFilename, &instances))
+    return 1;
+  for (std::unique_ptr<BatchInstance> &inst : instances)
+    for (std::uint32_t &seed : inst->seeds)
+      seed = seedGen();
+
+  std::atomic<int> solvedCnt(0);
+  std::atomic<int> failedCnt(0);
+  std::atomic<long long> totalCrossings(0);
+  Clock::time_point batchStart = Clock::now();
+  WorkStealingPool pool(threadCnt);
 
-  int r1 = m;
-  int r2 = sqrt(n) * n;  // 10 * n;  //n * n;
-  int r3 = n;
-  int r4 = n / 4 + 1;
-  int crCnt = Tools::countCrossingNumber(*gr);
-  BestFound SABest("", *gr);
-  SABest.restart();
-  for (int iter = begIter; iter < endIter && crCnt > 0; iter++)
-  //while (t > t1 && crCnt > 0)
+  auto finish = [&](BatchInstance *inst)
   {
-    double t = t0
-        + (1 / log(begIter) - 1 / log(iter)) * (t1 - t0)
-            / (1 / log(begIter) - 1 / log(endIter));
-    for (int c = 0; c < r1; c++)
+    int cr = inst->best->val();
+    inst->best->flush();
+    string error = inst->best->error();
+    inst->best.reset();
+    inst->origGr.reset();
+    if (error != "")
     {
-      Edge *ed = &(gr->e[edgeDistrib(mt)]);
-      int crDiff = -Tools::countEdgeCrossings(*gr, *ed);
-      int origP = ed->p;
-      int p = pageDistrib(mt);
-      if (p >= origP)
-        p++;
-      ed->p = p;
-      crDiff += Tools::countEdgeCrossings(*gr, *ed);
-      if (crDiff > 0 && zeroOneDistrib(mt) >= ::exp(-crDiff / t))
-      {
-        ed->p = origP;
-      }
-      else
-      {
-        crCnt += crDiff;
-        best->testIfBest(*gr, crCnt);
-        SABest.testIfBest(*gr, crCnt);
-      }
+      failedCnt++;
+      cerr << "Batch: " << inst->input << ": the best drawing was not written: " << error << endl;
+      return;
     }
-    for (int c = 0; c < r2; c++)
+    totalCrossings += cr;
+    solvedCnt++;
+    double seconds = std::chrono::duration<double>(Clock::now() - inst->start).count();
+    cout << "Batch: " << inst->input << " -> " << inst->output << ": " << cr
+         << " crossings in " << seconds << " s" << endl;
+  };
+  auto restart = [&](BatchInstance *inst, int i)
+  {
+    std::mt19937 mt(inst->seeds[i]);
+    BestFound *best = inst->best.get();
+    Graph graphSA;
+    if (i == 4)
+      best->copyGraph(&graphSA);
+    else
     {
-      int v1 = vertexDistrib(mt);
-      if (v1 == n - 1)
-        continue;
-      int crDiff = Tools::countCrossingChangeIfNeighborsSwapped(*gr, v1);
-      if (crDiff <= 0 || zeroOneDistrib(mt) < ::exp(-crDiff / t))
-      {
-        // do the change
-        Tools::swapVertices(gr, v1, v1 + 1);
-        crCnt += crDiff;
-        best->testIfBest(*gr, crCnt);
-        SABest.testIfBest(*gr, crCnt);
-      }
-
+      graphSA.loadFrom(*inst->origGr);
+      if (i == 0)
+        best->testIfBest(graphSA, Strategies::GreedyBB(&graphSA, best));
+      else if (i == 1)
+        best->testIfBest(graphSA, Strategies::BBGreedy(&graphSA, best));
+      else
+        Strategies::randomRestart(&graphSA, mt);
     }
-    for (int c = 0; c < r3; c++)
+    cout << "---------------------------------------" << endl;
+    annealRound(&graphSA, best, mt);
+  };
+
+  for (std::unique_ptr<BatchInstance> &instPtr : instances)
+  {
+    BatchInstance *inst = instPtr.get();
+    pool.submit([&, inst]()
     {
-      int v1 = vertexDistrib(mt);
-      int v2 = vertexDistrib(mt);
-      if (v1 == v2)
-        continue;
-      int crDiff = -Tools::countEdgesFromVertexCrossings(*gr, gr->v[v1]);
-      vector<Edge> edge_bck = gr->e;
-      Tools::moveVertex(gr, v1, v2);
-      Tools::greedyAtVertex(gr, v2);
-      crDiff += Tools::countEdgesFromVertexCrossings(*gr, gr->v[v2]);
-      if (crDiff > 0 && zeroOneDistrib(mt) >= ::exp(-crDiff / t))
-      {
-        //restore to original
-        Tools::moveVertex(gr, v2, v1);
-        for (unsigned i = 0; i < edge_bck.size(); i++)
-          gr->e[i].p = edge_bck[i].p;
-      }
-      else
+      inst->start = Clock::now();
+      inst->origGr.reset(new Graph());
+      try
       {
-        crCnt += crDiff;
-        best->testIfBest(*gr, crCnt);
-        SABest.testIfBest(*gr, crCnt);
+        Loader::loadFile(inst->input, inst->origGr.get());
       }
-    }
-    for (int c = 0; c < r4; c++)
-    {
-      int v1 = vertexDistrib(mt);
-      int v2 = 0;
-      int crDiff = Tools::findBestPositionForVertex(*gr, v1, &v2);
-      if (crDiff <= 0 || zeroOneDistrib(mt) < ::exp(-crDiff / t))
+      catch (std::exception &exc)
       {
-        // do the change
-        Tools::moveVertex(gr, v1, v2);
-        Tools::greedyAtVertex(gr, v2);
-        crCnt += crDiff;
-        assert(crCnt == Tools::countCrossingNumber(*gr));
-        best->testIfBest(*gr, crCnt);
-        SABest.testIfBest(*gr, crCnt);
+        cerr << "Batch: " << inst->input << ": " << exc.what() << endl;
+        inst->origGr.reset();
+        failedCnt++;
+        return;
       }
+      inst->best.reset(new BestFound(inst->output, *inst->origGr));
+      inst->restartsLeft = 4;
+      for (int i = 0; i < 4; i++)
+        pool.submit([&, inst, i]()
+        {
+          restart(inst, i);
+          if (--inst->restartsLeft == 0)
+            pool.submit([&, inst]()
+            {
+              restart(inst, 4);
+              finish(inst);
+            });
+        });
+    });
+  }
+  pool.wait();
 
-    }
-    //t *= alpha;
+  double hours = std::chrono::duration<double>(Clock::now() - batchStart).count() / 3600;
+  cout << "Batch finished: " << solvedCnt << " instances solved (" << failedCnt << " failed) with "
+       << totalCrossings << " crossings in total, in " << hours * 3600 << " s on " << threadCnt
+       << " threads (" << pool.stealCnt() << " tasks stolen)." << endl;
+  if (hours > 0)
+    cout << "Throughput: " << solvedCnt / hours << " instances per hour, "
+         << totalCrossings / hours << " crossings per hour." << endl;
+  return failedCnt > 0 ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+  int threadCnt = 1;
+  int replicaCnt = 0;
+  int evalThreadCnt = 1;
+  string statsFilename = "";
+  double statsInterval = 0;
+  double timeLimit = 0;
+  string checkpointFilename = "";
+  double checkpointInterval = 60;
+  bool resume = false;
+  string inputFilename = "";
+  string generateSpec = "";
+  string batchManifest = "";
+  string socketPath = "";
+  string filename = "";
+  bool argsOk = true;
+  for (int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if (arg == "--threads" && i + 1 < argc)
+      threadCnt = atoi(argv[++i]);
+    else if (arg == "--eval-threads" && i + 1 < argc)
+      evalThreadCnt = atoi(argv[++i]);
+    else if (arg == "--stats" && i + 1 < argc)
+      statsFilename = argv[++i];
+    else if (arg == "--stats-interval" && i + 1 < argc)
+      statsInterval = atof(argv[++i]);
+    else if (arg == "--time-limit" && i + 1 < argc)
+      timeLimit = atof(argv[++i]);
+    else if (arg == "--input" && i + 1 < argc)
+      inputFilename = argv[++i];
+    else if (arg == "--generate" && i + 1 < argc)
+      generateSpec = argv[++i];
+    else if (arg == "--batch" && i + 1 < argc)
+      batchManifest = argv[++i];
+    else if (arg == "--serve" && i + 1 < argc)
+      socketPath = argv[++i];
+    else if (arg == "--checkpoint" && i + 1 < argc)
+      checkpointFilename = argv[++i];
+    else if (arg == "--checkpoint-interval" && i + 1 < argc)
+      checkpointInterval = atof(argv[++i]);
+    else if (arg == "--resume")
+      resume = true;
+    else if (arg == "--tempering" && i + 1 < argc)
+      replicaCnt = atoi(argv[++i]);
+    else if (filename == "" && arg.size() > 0 && arg[0] != '-')
+      filename = arg;
+    else
+      argsOk = false;
   }
-  if (SABest.betterThanInitial())
+  bool batch = (batchManifest != "");
+  bool serve = (socketPath != "");
+  if (!argsOk || (filename == "") != (batch || serve) || (batch && serve) || threadCnt < 1 || replicaCnt < 0 || evalThreadCnt < 1
+      || timeLimit < 0 || (inputFilename != "" && generateSpec != "")
+      || (resume && checkpointFilename == "")
+      || (checkpointFilename != "" && (replicaCnt > 0 || timeLimit > 0))
+      || ((batch || serve) && (inputFilename != "" || generateSpec != "" || checkpointFilename != ""
+          || replicaCnt > 0 || timeLimit > 0)))
   {
-    gr->loadFrom(SABest.gr());
-    int finalCr = SABest.val();
-    assert(finalCr <= crCnt);
-    assert(finalCr == Tools::countCrossingNumber(*gr));
-    cout << endl << "SimAnneal before BBgreedy: Last value: " << crCnt
-         << ", best value (will be used): " << finalCr << endl;
-    crCnt = finalCr;
+    cerr << usage;
+    return 0;
   }
-  else
+
+  if (timeLimit > 0)
+    Deadline::set(timeLimit);
+  Tools::setEvalThreads(evalThreadCnt);
+  if (statsFilename != "")
+    Stats::start(statsFilename, statsInterval);
+
+  if (serve)
   {
-    cout << endl << "SimAnneal before BBgreedy: Last value (will be used): "
-         << crCnt << ", best value is the initial (" << SABest.val() << ")"
-         << endl;
+    int ret = Server(socketPath, threadCnt).run();
+    Stats::finish();
+    return ret;
   }
-  crCnt = BBGreedy(gr, best);
-  cout << "SimAnneal: " << crCnt << endl;
-  return crCnt;
-}
 
-int main(int argc, char *argv[])
-{
-  if (argc != 2)
+  if (batch)
   {
-    cerr << "One parameter is required - the output filename." << endl;
-    return 0;
+    std::random_device rd;
+    std::seed_seq seeds{rd(), rd(), rd(), rd()};
+    std::uint32_t seed;
+    seeds.generate(&seed, &seed + 1);
+    std::mt19937 seedGen(seed);
+    int ret = runBatch(batchManifest, threadCnt, seedGen);
+    Stats::finish();
+    return ret;
   }
 
-  string filename = string(argv[1]);
   Graph origGr;
 
-  Loader::load(std::cin, &origGr);
-  cout << "Loaded graph has " << Tools::countCrossingNumber(origGr)
+  if (generateSpec != "")
+  {
+    try
+    {
+      GraphBuilder builder(&origGr);
+      Generators::generate(generateSpec, &builder);
+    }
+    catch (std::invalid_argument &exc)
+    {
+      cerr << exc.what() << endl << usage;
+      Stats::finish();
+      return 1;
+    }
+    cout << "Generated graph with " << origGr.v.size() << " vertices and "
+         << origGr.e.size() << " edges." << endl;
+  }
+  else
+  {
+    try
+    {
+      if (inputFilename != "")
+        Loader::loadFile(inputFilename, &origGr);
+      else
+        Loader::load(std::cin, &origGr);
+    }
+    catch (std::exception &exc)
+    {
+      cerr << exc.what() << endl;
+      Stats::finish();
+      return 1;
+    }
+  }
+  cout << "Loaded graph has " << Tools::countCrossingNumberFast(origGr)
        << " crossings." << endl;
 
   BestFound best(filename, origGr);
 
-  int n = static_cast<int>(origGr.v.size());
-
-  Graph graphGBB(origGr);
-  int valGBB = GreedyBB(&graphGBB, &best);
-  best.testIfBest(graphGBB, valGBB);
+  int iterCnt = std::max(5, threadCnt);
+  std::unique_ptr<Checkpoint> cp;
+  if (checkpointFilename != "")
+  {
+    cp.reset(new Checkpoint(checkpointFilename, origGr, iterCnt, checkpointInterval));
+    Graph bestGr;
+    if (resume && cp->load(&bestGr))
+    {
+      cout << "Resuming from " << checkpointFilename << endl;
+      if (!bestGr.v.empty())
+        best.testIfBest(bestGr, -1);
+      iterCnt = cp->taskCnt();
+    }
+  }
 
-  Graph graphBBG(origGr);
-  int valBBG = BBGreedy(&graphBBG, &best);
-  best.testIfBest(graphBBG, valBBG);
+  // Every task gets its own random generator and its own copy of the graph.
+  std::random_device rd;
+  std::seed_seq seeds{rd(), rd(), rd(), rd()};
+  vector<std::uint32_t> taskSeeds(iterCnt);
+  seeds.generate(taskSeeds.begin(), taskSeeds.end());
 
-  // In every iteration, the starting solution is changed - first graphGBB and graphBBG
-  // are used, afterwards, a random vertex ordering is used.
-  // Next, the simmulated annealing with high initial temperature starts, followed
-  // by another with a lower initial temperature.
-  int iterCnt = 5;
-  for (int i = 0; i < iterCnt; i++)
+  if (replicaCnt > 0)
   {
-    cout << "---------------------------------------" << endl;
-    Graph graphSA;
-    if (i == 0)
-      graphSA.loadFrom(graphGBB);
-    else if (i == 1)
-      graphSA.loadFrom(graphBBG);
-    else if (i % 5 == 4)
-      graphSA.loadFrom(best.gr());
-    else  // random shuffle
     {
-      graphSA.loadFrom(origGr);
-      for (int j = 0; j < 10 * n; j++)
+      ThreadPool pool(std::min(threadCnt, 2));
+      pool.submit([&]()
       {
-        std::uniform_int_distribution<int> vertexDistrib(0, n - 1);
-        int v1 = vertexDistrib(mt);
-        int v2 = vertexDistrib(mt);
-        if (v1 == v2)
-          continue;
-        Tools::moveVertex(&graphSA, v1, v2);
-      }
-      int crTmp = Tools::countCrossingNumber(graphSA);
-      Tools::restartEdges(&graphSA, crTmp, Tools::lenPages);
+        Graph gr(origGr);
+        best.testIfBest(gr, Strategies::GreedyBB(&gr, &best));
+      });
+      pool.submit([&]()
+      {
+        Graph gr(origGr);
+        best.testIfBest(gr, Strategies::BBGreedy(&gr, &best));
+      });
     }
+    std::mt19937 mt(taskSeeds[0]);
+    Graph graphPT;
+    best.copyGraph(&graphPT);
+    cout << "---------------------------------------" << endl;
+    ReplicaExchange engine(replicaCnt, threadCnt);
+    best.testIfBest(graphPT, engine.run(&graphPT, &best, mt));
+    return finishRun(&best);
+  }
 
-    int valSA = simAnneal(&graphSA, 64, &best);
-    best.testIfBest(graphSA, valSA);
+  if (timeLimit > 0)
+  {
+    std::mt19937 seedGen(taskSeeds[0]);
+    runUntilDeadline(origGr, &best, threadCnt, seedGen);
+    return finishRun(&best);
+  }
 
-    valSA = simAnneal(&graphSA, 8, &best);
-    best.testIfBest(graphSA, valSA);
+  // In every iteration, the starting solution is changed - first the results of GreedyBB and BBGreedy
+  // are used, afterwards, a random vertex ordering is used, and every fifth iteration starts from the best
+  // solution found so far (those are run after all the others have finished).
+  // With a checkpoint, the finished iterations are skipped and the running ones continue from their state.
+  ThreadPool pool(threadCnt);
+  for (int i = 0; i < iterCnt; i++)
+  {
+    if (i % 5 == 4)
+      continue;
+    pool.submit([&, i]()
+    {
+      if (cp && cp->isDone(i))
+        return;
+      std::mt19937 mt(taskSeeds[i]);
+      Graph graphSA(origGr);
+      Checkpoint::TaskState state;
+      bool resumed = (cp && cp->runningState(i, &state));
+      if (resumed)
+      {
+        cp->restoreGraph(state.ids, state.pages, &graphSA);
+        Checkpoint::restoreRng(state.rng, &mt);
+      }
+      else if (i == 0)
+        best.testIfBest(graphSA, Strategies::GreedyBB(&graphSA, &best));
+      else if (i == 1)
+        best.testIfBest(graphSA, Strategies::BBGreedy(&graphSA, &best));
+      else
+        Strategies::randomRestart(&graphSA, mt);
+      cout << "---------------------------------------" << endl;
+      annealRound(&graphSA, &best, mt, 0, cp.get(), i, resumed ? &state : nullptr);
+      if (cp)
+        cp->finishTask(i, best);
+    });
+  }
+  pool.wait();
+  for (int i = 4; i < iterCnt; i += 5)
+  {
+    pool.submit([&, i]()
+    {
+      if (cp && cp->isDone(i))
+        return;
+      std::mt19937 mt(taskSeeds[i]);
+      Graph graphSA;
+      Checkpoint::TaskState state;
+      bool resumed = (cp && cp->runningState(i, &state));
+      if (resumed)
+      {
+        cp->restoreGraph(state.ids, state.pages, &graphSA);
+        Checkpoint::restoreRng(state.rng, &mt);
+      }
+      else
+        best.copyGraph(&graphSA);
+      cout << "---------------------------------------" << endl;
+      annealRound(&graphSA, &best, mt, 0, cp.get(), i, resumed ? &state : nullptr);
+      if (cp)
+        cp->finishTask(i, best);
+    });
   }
-  cout << "Result is: " << best.val() << endl;
+  pool.wait();
+  return finishRun(&best);
 }
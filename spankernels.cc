@@ -0,0 +1,179 @@
+/**
+ * Kernels scanning a contiguous range of adjacency slots of a FlatGraph, with an AVX2 variant.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include "spankernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BOOK_EMBEDDER_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+bool SpanKernels::useAvx2_ = SpanKernels::avx2Available();
+
+bool SpanKernels::avx2Available()
+{
+#ifdef BOOK_EMBEDDER_HAVE_AVX2
+  __builtin_cpu_init();  // useAvx2_ is initialized before the constructors that would do it
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+bool SpanKernels::enableAvx2(bool enable)
+{
+  useAvx2_ = (enable && avx2Available());
+  return useAvx2_ == enable;
+}
+
+/**
+ * Number of slots in [beg,end) that are on the page and go over the edge v1-v2.
+ */
+int SpanKernels::countCrossingsScalar(const int *other, const int *pages,
+                                      int beg, int end, int v1, int v2,
+                                      int page)
+{
+  int result = 0;
+  for (int s = beg; s < end; s++)
+    result += (pages[s] == page && (other[s] < v1 || other[s] > v2));
+  return result;
+}
+
+/**
+ * For every page p >= 0, adds to hist[p] the number of slots in [beg,end) on page p
+ * that go over the edge v1-v2.
+ */
+void SpanKernels::pageHistogramScalar(const int *other, const int *pages,
+                                      int beg, int end, int v1, int v2,
+                                      int pageCnt, unsigned *hist)
+{
+  (void) pageCnt;
+  for (int s = beg; s < end; s++)
+    if (pages[s] >= 0 && (other[s] < v1 || other[s] > v2))
+      hist[pages[s]]++;
+}
+
+#ifdef BOOK_EMBEDDER_HAVE_AVX2
+
+/**
+ * Mask of the 8 slots from s on that go over the edge v1-v2.
+ */
+__attribute__((target("avx2")))
+static inline __m256i overMask(const int *other, int s, __m256i v1v,
+                               __m256i v2v)
+{
+  __m256i o = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(other + s));
+  return _mm256_or_si256(_mm256_cmpgt_epi32(v1v, o),
+                         _mm256_cmpgt_epi32(o, v2v));
+}
+
+/**
+ * Compares 8 slots at once; the matching lanes are -1, so they are subtracted from the counter.
+ */
+__attribute__((target("avx2")))
+int SpanKernels::countCrossingsAvx2(const int *other, const int *pages,
+                                    int beg, int end, int v1, int v2, int page)
+{
+  __m256i v1v = _mm256_set1_epi32(v1);
+  __m256i v2v = _mm256_set1_epi32(v2);
+  __m256i pv = _mm256_set1_epi32(page);
+  __m256i acc = _mm256_setzero_si256();
+  int s = beg;
+  for (; s + 8 <= end; s += 8)
+  {
+    __m256i pg = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(pages + s));
+    __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi32(pg, pv),
+                                   overMask(other, s, v1v, v2v));
+    acc = _mm256_sub_epi32(acc, hit);
+  }
+  alignas(32) int lanes[8];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+  int result = 0;
+  for (int lane : lanes)
+    result += lane;
+  return result + countCrossingsScalar(other, pages, s, end, v1, v2, page);
+}
+
+/**
+ * With few pages, every page gets its own vector counter; otherwise the lanes selected by the mask
+ * are added one by one.
+ */
+__attribute__((target("avx2")))
+void SpanKernels::pageHistogramAvx2(const int *other, const int *pages,
+                                    int beg, int end, int v1, int v2,
+                                    int pageCnt, unsigned *hist)
+{
+  const int maxVectorPages = 8;
+  __m256i v1v = _mm256_set1_epi32(v1);
+  __m256i v2v = _mm256_set1_epi32(v2);
+  int s = beg;
+  if (pageCnt <= maxVectorPages)
+  {
+    __m256i acc[maxVectorPages];
+    __m256i pv[maxVectorPages];
+    for (int p = 0; p < pageCnt; p++)
+    {
+      acc[p] = _mm256_setzero_si256();
+      pv[p] = _mm256_set1_epi32(p);
+    }
+    for (; s + 8 <= end; s += 8)
+    {
+      __m256i pg = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(pages + s));
+      __m256i over = overMask(other, s, v1v, v2v);
+      for (int p = 0; p < pageCnt; p++)
+        acc[p] = _mm256_sub_epi32(
+            acc[p], _mm256_and_si256(_mm256_cmpeq_epi32(pg, pv[p]), over));
+    }
+    for (int p = 0; p < pageCnt; p++)
+    {
+      alignas(32) int lanes[8];
+      _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc[p]);
+      for (int lane : lanes)
+        hist[p] += lane;
+    }
+  }
+  else
+  {
+    __m256i minusOne = _mm256_set1_epi32(-1);
+    for (; s + 8 <= end; s += 8)
+    {
+      __m256i pg = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(pages + s));
+      __m256i hit = _mm256_and_si256(_mm256_cmpgt_epi32(pg, minusOne),
+                                     overMask(other, s, v1v, v2v));
+      unsigned bits = _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+      while (bits != 0)
+      {
+        hist[pages[s + __builtin_ctz(bits)]]++;
+        bits &= bits - 1;
+      }
+    }
+  }
+  pageHistogramScalar(other, pages, s, end, v1, v2, pageCnt, hist);
+}
+
+#else
+
+int SpanKernels::countCrossingsAvx2(const int *other, const int *pages,
+                                    int beg, int end, int v1, int v2, int page)
+{
+  return countCrossingsScalar(other, pages, beg, end, v1, v2, page);
+}
+
+void SpanKernels::pageHistogramAvx2(const int *other, const int *pages,
+                                    int beg, int end, int v1, int v2,
+                                    int pageCnt, unsigned *hist)
+{
+  pageHistogramScalar(other, pages, beg, end, v1, v2, pageCnt, hist);
+}
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * Kernels scanning a contiguous range of adjacency slots of a FlatGraph, with an AVX2 variant.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_SPANKERNELS_H_
+#define BOOK_EMBEDDER_SPANKERNELS_H_
+
+/**
+ * A slot s goes over the edge v1-v2 (v1 < v2), if it lies strictly inside the edge
+ * (which the caller ensures by the range of slots) and its other end-point other[s] is outside of [v1,v2].
+ * The AVX2 variant is used if the CPU supports it (checked at run time), otherwise the scalar one.
+ */
+class SpanKernels
+{
+ public:
+  static int countCrossings(const int *other, const int *pages, int beg,
+                            int end, int v1, int v2, int page)
+  {
+    if (useAvx2_)
+      return countCrossingsAvx2(other, pages, beg, end, v1, v2, page);
+    return countCrossingsScalar(other, pages, beg, end, v1, v2, page);
+  }
+
+  static void pageHistogram(const int *other, const int *pages, int beg,
+                            int end, int v1, int v2, int pageCnt,
+                            unsigned *hist)
+  {
+    if (useAvx2_)
+      pageHistogramAvx2(other, pages, beg, end, v1, v2, pageCnt, hist);
+    else
+      pageHistogramScalar(other, pages, beg, end, v1, v2, pageCnt, hist);
+  }
+
+  static bool avx2Available();
+
+  /**
+   * Switches between the AVX2 and the scalar variant (for benchmarks). Returns false and keeps the scalar
+   * variant if AVX2 is requested but not available.
+   */
+  static bool enableAvx2(bool enable);
+
+  static bool avx2Enabled()
+  {
+    return useAvx2_;
+  }
+
+ private:
+  static bool useAvx2_;
+
+  static int countCrossingsScalar(const int *other, const int *pages, int beg,
+                                  int end, int v1, int v2, int page);
+
+  static int countCrossingsAvx2(const int *other, const int *pages, int beg,
+                                int end, int v1, int v2, int page);
+
+  static void pageHistogramScalar(const int *other, const int *pages, int beg,
+                                  int end, int v1, int v2, int pageCnt,
+                                  unsigned *hist);
+
+  static void pageHistogramAvx2(const int *other, const int *pages, int beg,
+                                int end, int v1, int v2, int pageCnt,
+                                unsigned *hist);
+};
+
+#endif
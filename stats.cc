@@ -0,0 +1,213 @@
+/**
+ * Timers and counters of the phases and of the simulated annealing moves.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "stats.h"
+
+using std::string;
+using std::vector;
+using std::endl;
+
+namespace
+{
+
+const char *counterNames[Stats::counterCnt] = { "BaurBrandes", "BBGreedy",
+    "GreedyBB", "simAnneal", "randomRestart", "ReplicaExchange", "greedyPages",
+    "lenPages", "restartEdges", "countCrossingNumberFast", "verifyAndWrite",
+    "page", "swap", "moveGreedy", "bestPosition" };
+
+/**
+ * Written only by its own thread, so relaxed loads and stores are enough; other threads only read it.
+ */
+struct Record
+{
+  std::atomic<long long> calls;
+  std::atomic<long long> nanos;
+  std::atomic<long long> proposals;
+  std::atomic<long long> accepted;
+  std::atomic<long long> crDiffSum;
+};
+
+struct ThreadRecords
+{
+  Record r[Stats::counterCnt];
+};
+
+void bump(std::atomic<long long> &x, long long val)
+{
+  x.store(x.load(std::memory_order_relaxed) + val, std::memory_order_relaxed);
+}
+
+long long get(const std::atomic<long long> &x)
+{
+  return x.load(std::memory_order_relaxed);
+}
+
+std::mutex recordsMutex;
+vector<std::unique_ptr<ThreadRecords> > allRecords;  ///< Kept after their threads end.
+
+string statsFilename;
+Stats::Clock::time_point startTime;
+std::mutex periodicMutex;
+std::condition_variable periodicWake;
+bool periodicStopping = false;
+
+/**
+ * The thread writing the stats every interval. It is stopped by Stats::finish or, if main returns
+ * without calling it, when the static objects are destroyed (the objects it uses are defined above,
+ * so they are destroyed after it).
+ */
+struct PeriodicWriter
+{
+  std::thread thread;
+
+  ~PeriodicWriter()
+  {
+    stop();
+  }
+
+  void stop()
+  {
+    if (!thread.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(periodicMutex);
+      periodicStopping = true;
+    }
+    periodicWake.notify_one();
+    thread.join();
+  }
+} periodicWriter;
+
+ThreadRecords &localRecords()
+{
+  thread_local ThreadRecords *rec = nullptr;
+  if (rec == nullptr)
+  {
+    std::lock_guard<std::mutex> lock(recordsMutex);
+    allRecords.push_back(std::unique_ptr<ThreadRecords>(new ThreadRecords()));
+    rec = allRecords.back().get();
+  }
+  return *rec;
+}
+
+}
+
+bool Stats::enabled_ = false;
+
+void Stats::addTime(Counter c, Clock::duration time)
+{
+  Record &rec = localRecords().r[c];
+  bump(rec.calls, 1);
+  bump(rec.nanos,
+       std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+}
+
+void Stats::recordMove(Counter c, bool accepted, int crDiff)
+{
+  Record &rec = localRecords().r[c];
+  bump(rec.proposals, 1);
+  if (accepted)
+    bump(rec.accepted, 1);
+  bump(rec.crDiffSum, crDiff);
+}
+
+void Stats::start(const string &filename, double interval)
+{
+  statsFilename = filename;
+  startTime = Clock::now();
+  enabled_ = true;
+  if (interval > 0)
+    periodicWriter.thread = std::thread(&Stats::periodicLoop, interval);
+}
+
+void Stats::finish()
+{
+  if (!enabled_)
+    return;
+  periodicWriter.stop();
+  writeFile();
+}
+
+void Stats::periodicLoop(double interval)
+{
+  std::unique_lock<std::mutex> lock(periodicMutex);
+  while (!periodicWake.wait_for(lock, std::chrono::duration<double>(interval),
+                                []()
+                                { return periodicStopping;}))
+    writeFile();
+}
+
+/**
+ * The file is replaced at once, so a reader never sees a partially written one.
+ */
+void Stats::writeFile()
+{
+  string tmpName = statsFilename + ".tmp";
+  {
+    std::ofstream ostr(tmpName.c_str());
+    if (!ostr.is_open())
+      return;
+    writeJson(ostr);
+  }
+  std::rename(tmpName.c_str(), statsFilename.c_str());
+}
+
+/**
+ * Sums the records of all the threads. Phases have calls and seconds; moves have seconds of their loops,
+ * the numbers of proposals and acceptances, the acceptance rate and the mean change of the crossing number.
+ */
+void Stats::writeJson(std::ostream &ostr)
+{
+  vector<vector<long long> > sum(counterCnt, vector<long long>(5, 0));
+  {
+    std::lock_guard<std::mutex> lock(recordsMutex);
+    for (const std::unique_ptr<ThreadRecords> &rec : allRecords)
+      for (int c = 0; c < counterCnt; c++)
+      {
+        sum[c][0] += get(rec->r[c].calls);
+        sum[c][1] += get(rec->r[c].nanos);
+        sum[c][2] += get(rec->r[c].proposals);
+        sum[c][3] += get(rec->r[c].accepted);
+        sum[c][4] += get(rec->r[c].crDiffSum);
+      }
+  }
+
+  double elapsed = std::chrono::duration<double>(Clock::now() - startTime).count();
+  ostr << "{" << endl;
+  ostr << "  \"elapsed_s\": " << elapsed << "," << endl;
+  ostr << "  \"phases\": {" << endl;
+  for (int c = 0; c < MovePage; c++)
+    ostr << "    \"" << counterNames[c] << "\": {\"calls\": " << sum[c][0]
+         << ", \"seconds\": " << sum[c][1] * 1e-9 << "}"
+         << (c + 1 < MovePage ? "," : "") << endl;
+  ostr << "  }," << endl;
+  ostr << "  \"moves\": {" << endl;
+  for (int c = MovePage; c < counterCnt; c++)
+  {
+    long long proposals = sum[c][2];
+    double rate = (proposals > 0 ? sum[c][3] / double(proposals) : 0);
+    double meanDiff = (proposals > 0 ? sum[c][4] / double(proposals) : 0);
+    ostr << "    \"" << counterNames[c] << "\": {\"seconds\": "
+         << sum[c][1] * 1e-9 << ", \"proposals\": " << proposals
+         << ", \"accepted\": " << sum[c][3] << ", \"acceptance_rate\": "
+         << rate << ", \"mean_crDiff\": " << meanDiff << "}"
+         << (c + 1 < counterCnt ? "," : "") << endl;
+  }
+  ostr << "  }" << endl;
+  ostr << "}" << endl;
+}
@@ -0,0 +1,131 @@
+/**
+ * Timers and counters of the phases and of the simulated annealing moves.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_STATS_H_
+#define BOOK_EMBEDDER_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+
+/**
+ * Every thread accumulates into its own records, which are summed only when the stats are written.
+ * Until start is called, the stats are disabled and every timer or counter costs a single test
+ * of a flag. Times of the phases are inclusive (BBGreedy contains the BaurBrandes inside it)
+ * and summed over the threads.
+ */
+class Stats
+{
+ public:
+  enum Counter
+  {
+    BaurBrandes,
+    BBGreedy,
+    GreedyBB,
+    SimAnneal,
+    RandomRestart,
+    ReplicaExchange,
+    GreedyPages,
+    LenPages,
+    RestartEdges,
+    CountCrossingsFast,
+    VerifyAndWrite,
+    MovePage,  ///< r1 of the annealing: a random edge to a random page.
+    MoveSwap,  ///< r2: a swap of two neighboring vertices.
+    MoveGreedy,  ///< r3: a random move of a vertex followed by greedy pages of its edges.
+    MoveBestPos,  ///< r4: a vertex to its best position.
+    counterCnt
+  };
+
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * Measures the time from the construction to the destruction (or to switchTo).
+   */
+  class Timer
+  {
+   public:
+    explicit Timer(Counter c)
+        : c_(c),
+          running_(enabled_)
+    {
+      if (running_)
+        start_ = Clock::now();
+    }
+
+    ~Timer()
+    {
+      if (running_)
+        addTime(c_, Clock::now() - start_);
+    }
+
+    Timer(const Timer &other) = delete;
+    Timer& operator=(const Timer &other) = delete;
+
+    /**
+     * Stops measuring the current counter and starts measuring c.
+     */
+    void switchTo(Counter c)
+    {
+      if (running_)
+      {
+        Clock::time_point now = Clock::now();
+        addTime(c_, now - start_);
+        start_ = now;
+      }
+      c_ = c;
+    }
+
+   private:
+    Counter c_;
+    bool running_;
+    Clock::time_point start_;
+  };
+
+  static bool enabled()
+  {
+    return enabled_;
+  }
+
+  /**
+   * Counts a proposed move of the annealing; crDiff is its change of the crossing number.
+   */
+  static void move(Counter c, bool accepted, int crDiff)
+  {
+    if (enabled_)
+      recordMove(c, accepted, crDiff);
+  }
+
+  /**
+   * Enables the stats. They are written to filename by finish and, if interval is positive,
+   * also every interval seconds. Must be called before any other threads are started.
+   */
+  static void start(const std::string &filename, double interval);
+
+  /**
+   * Stops the periodic writing and writes the final stats.
+   */
+  static void finish();
+
+  static void writeJson(std::ostream &ostr);
+
+ private:
+  static bool enabled_;
+
+  static void addTime(Counter c, Clock::duration time);
+
+  static void recordMove(Counter c, bool accepted, int crDiff);
+
+  static void writeFile();
+
+  static void periodicLoop(double interval);
+};
+
+#endif
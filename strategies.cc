@@ -0,0 +1,344 @@
+/**
+ * The strategies for minimizing the number of crossings used by the solver.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+#include "strategies.h"
+#include "crossingstate.h"
+#include "deadline.h"
+#include "pagecostcache.h"
+#include "stats.h"
+#include "tools.h"
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+/**
+ * Moves every vertex to its best position (and its edges to their best pages) until no move improves.
+ */
+void Strategies::BaurBrandes(Graph *gr, BestFound *best)
+{
+  Stats::Timer timer(Stats::BaurBrandes);
+  int n = static_cast<int>(gr->v.size());
+  bool improved = true;
+  while (improved && !Deadline::passed())
+  {
+    improved = false;
+    for (int i = 0; i < n && !Deadline::passed(); i++)
+    {
+      int bestPos;
+      int change = Tools::findBestPositionForVertex(*gr, i, &bestPos);
+      if (change < 0)
+      {
+        Tools::moveVertex(gr, i, bestPos);
+        Tools::greedyAtVertex(gr, bestPos);
+        improved = true;
+      }
+    }
+    if (improved)
+      best->testIfBest(*gr, -1);
+  }
+}
+
+/**
+ * Alternates BaurBrandes with greedy page assignments until the crossing number stops changing.
+ */
+int Strategies::BBGreedy(Graph *gr, BestFound *best)
+{
+  Stats::Timer timer(Stats::BBGreedy);
+  while (!Deadline::passed())
+  {
+    int oldCr = Tools::countCrossingNumberFast(*gr);
+    BaurBrandes(gr, best);
+    int newCr = Tools::countCrossingNumberFast(*gr);
+
+    best->testIfBest(*gr, newCr);
+
+    Tools::greedyPages(gr);
+    newCr = Tools::countCrossingNumberFast(*gr);
+    best->testIfBest(*gr, newCr);
+    newCr = Tools::restartEdges(gr, newCr, Tools::lenPages);
+    newCr = Tools::restartEdges(gr, newCr, Tools::greedyPages);
+
+    if (newCr == oldCr)
+      break;
+    best->testIfBest(*gr, newCr);
+  }
+  int finalCr = Tools::countCrossingNumberFast(*gr);
+  cout << endl << "BBGreedy: " << finalCr << endl;
+  return finalCr;
+}
+
+/**
+ * The same as BBGreedy, but starts with the greedy page assignment.
+ */
+int Strategies::GreedyBB(Graph *gr, BestFound *best)
+{
+  Stats::Timer timer(Stats::GreedyBB);
+  while (!Deadline::passed())
+  {
+    int oldCr = Tools::countCrossingNumberFast(*gr);
+    Tools::greedyPages(gr);
+    int newCr = Tools::countCrossingNumberFast(*gr);
+    best->testIfBest(*gr, newCr);
+
+    newCr = Tools::restartEdges(gr, newCr, Tools::lenPages);
+    newCr = Tools::restartEdges(gr, newCr, Tools::greedyPages);
+    best->testIfBest(*gr, newCr);
+
+    BaurBrandes(gr, best);
+    newCr = Tools::countCrossingNumberFast(*gr);
+    if (newCr == oldCr)
+      break;
+
+    best->testIfBest(*gr, newCr);
+  }
+  int finalCr = Tools::countCrossingNumberFast(*gr);
+  cout << endl << "GreedyBB: " << finalCr << endl;
+  return finalCr;
+}
+
+/**
+ * One step of the simulated annealing at the temperature t: a fixed number of random moves of each
+ * of the four types (page of an edge, swap of two neighboring vertices, move of a vertex followed by
+ * greedy pages of its edges, and move of a vertex to its best position), each accepted with the
+ * Metropolis criterion. The crossings are kept in state; every accepted move is reported to best and
+ * localBest. Returns the current crossing number.
+ */
+int Strategies::annealStep(Graph *gr, CrossingState *state, double t,
+                           BestFound *best, BestFound *localBest,
+                           std::mt19937 &mt)
+{
+  int m = gr->e.size();
+  int n = gr->v.size();
+  std::uniform_int_distribution<int> vertexDistrib(0, n - 1);
+  std::uniform_int_distribution<int> edgeDistrib(0, m - 1);
+  std::uniform_int_distribution<int> pageDistrib(0, gr->p - 2);
+  std::uniform_real_distribution<double> zeroOneDistrib(0, 1);
+
+  int r1 = m;
+  int r2 = sqrt(n) * n;  // 10 * n;  //n * n;
+  int r3 = n;
+  int r4 = n / 4 + 1;
+  int crCnt = state->total();
+  UndoLog undo;
+  Stats::Timer timer(Stats::MovePage);
+  // Only the pages change in this loop, so the crossings of every edge on every page are looked up:
+  // on the bitsets of the conflict matrix for small graphs, otherwise in a cache of their costs
+  // if building it is cheaper than scanning the spans of the moved edges.
+  ConflictMatrix *conflicts = state->conflicts();
+  bool bitsets = ConflictMatrix::fits(*gr);
+  PageCostCache pageCost;
+  bool cached = !bitsets && PageCostCache::worthBuilding(*gr, r1);
+  if (bitsets)
+    conflicts->update(*gr);
+  else if (cached)
+    pageCost.build(*gr);
+  for (int c = 0; c < r1; c++)
+  {
+    if (Deadline::passed())
+      return crCnt;
+    Edge *ed = &(gr->e[edgeDistrib(mt)]);
+    int origP = ed->p;
+    int p = pageDistrib(mt);
+    if (p >= origP)
+      p++;
+    int crDiff = (bitsets ? conflicts->pageChangeDiff(*gr, *ed, p)
+        : cached ? pageCost.pageChangeDiff(*gr, *ed, p)
+        : state->pageChangeDiff(*gr, *ed, p));
+    bool accept = (crDiff <= 0 || zeroOneDistrib(mt) < ::exp(-crDiff / t));
+    Stats::move(Stats::MovePage, accept, crDiff);
+    if (accept)
+    {
+      if (bitsets)
+        state->changePage(gr, ed, p, conflicts);
+      else if (cached)
+        state->changePage(gr, ed, p, &pageCost);
+      else
+        state->changePage(gr, ed, p);
+      crCnt = state->total();
+      best->testIfBest(*gr, crCnt);
+      localBest->testIfBest(*gr, crCnt);
+    }
+  }
+  timer.switchTo(Stats::MoveSwap);
+  for (int c = 0; c < r2; c++)
+  {
+    if (Deadline::passed())
+      return crCnt;
+    int v1 = vertexDistrib(mt);
+    if (v1 == n - 1)
+      continue;
+    int crDiff = Tools::countCrossingChangeIfNeighborsSwapped(*gr, v1);
+    bool accept = (crDiff <= 0 || zeroOneDistrib(mt) < ::exp(-crDiff / t));
+    Stats::move(Stats::MoveSwap, accept, crDiff);
+    if (accept)
+    {
+      // do the change
+      state->swapNeighbors(gr, v1);
+      crCnt = state->total();
+      best->testIfBest(*gr, crCnt);
+      localBest->testIfBest(*gr, crCnt);
+    }
+
+  }
+  timer.switchTo(Stats::MoveGreedy);
+  for (int c = 0; c < r3; c++)
+  {
+    if (Deadline::passed())
+      return crCnt;
+    int v1 = vertexDistrib(mt);
+    int v2 = vertexDistrib(mt);
+    if (v1 == v2)
+      continue;
+    // The crossings of the moved edges are removed from the state until the move is decided.
+    state->detachVertex(*gr, v1);
+    int crDiff = state->total() - crCnt;
+    undo.clear();
+    Tools::moveVertex(gr, v1, v2, &undo);
+    Tools::greedyAtVertex(gr, v2, &undo);
+    crDiff += Tools::countEdgesFromVertexCrossings(*gr, gr->v[v2]);
+    bool accept = (crDiff <= 0 || zeroOneDistrib(mt) < ::exp(-crDiff / t));
+    Stats::move(Stats::MoveGreedy, accept, crDiff);
+    if (!accept)
+    {
+      //restore to original
+      Tools::rollback(gr, &undo);
+      state->attachVertex(*gr, v1);
+    }
+    else
+    {
+      state->attachVertex(*gr, v2);
+      crCnt = state->total();
+      best->testIfBest(*gr, crCnt);
+      localBest->testIfBest(*gr, crCnt);
+    }
+  }
+  timer.switchTo(Stats::MoveBestPos);
+  for (int c = 0; c < r4; c++)
+  {
+    if (Deadline::passed())
+      return crCnt;
+    int v1 = vertexDistrib(mt);
+    int v2 = 0;
+    int crDiff = Tools::findBestPositionForVertex(*gr, v1, &v2);
+    bool accept = (crDiff <= 0 || zeroOneDistrib(mt) < ::exp(-crDiff / t));
+    Stats::move(Stats::MoveBestPos, accept, crDiff);
+    if (accept)
+    {
+      // do the change
+      state->detachVertex(*gr, v1);
+      Tools::moveVertex(gr, v1, v2);
+      Tools::greedyAtVertex(gr, v2);
+      state->attachVertex(*gr, v2);
+      assert(state->total() == crCnt + crDiff);
+      crCnt = state->total();
+      best->testIfBest(*gr, crCnt);
+      localBest->testIfBest(*gr, crCnt);
+    }
+
+  }
+  return crCnt;
+}
+
+/**
+ * Simulated annealing from the initial temperature t0, followed by BBGreedy.
+ * Random choices are taken from mt.
+ * If seconds is positive, the schedule is stretched or shrunk to take that long: the temperature
+ * follows the same curve, but according to the elapsed fraction of the time instead of the step count.
+ */
+int Strategies::simAnneal(Graph *gr, double t0, BestFound *best,
+                          std::mt19937 &mt, double seconds,
+                          AnnealResume *resume)
+{
+  Stats::Timer timer(Stats::SimAnneal);
+//  double t = t0;
+  double t1 = 0.2;
+  int endIter = 1000;
+  int begIter = endIter / 50;
+//  double alpha = 0.999;
+  CrossingState state(*gr);
+  int crCnt = state.total();
+  BestFound SABest("", *gr);
+  SABest.restart();
+  int firstStep = 0;
+  if (resume != nullptr)
+  {
+    firstStep = resume->step;
+    if (resume->localBestVal >= 0)
+      SABest.testIfBest(resume->localBest, resume->localBestVal);
+  }
+  Deadline::Clock::time_point start = Deadline::Clock::now();
+  for (int step = firstStep; crCnt > 0 && !Deadline::passed(); step++)
+  //while (t > t1 && crCnt > 0)
+  {
+    double iter = begIter + step;
+    if (seconds > 0)
+      iter = begIter
+          + (endIter - begIter)
+              * std::chrono::duration<double>(Deadline::Clock::now() - start).count()
+              / seconds;
+    if (iter >= endIter)
+      break;
+    double t = t0
+        + (1 / log(begIter) - 1 / log(iter)) * (t1 - t0)
+            / (1 / log(begIter) - 1 / log(endIter));
+    crCnt = annealStep(gr, &state, t, best, &SABest, mt);
+    if (resume != nullptr && resume->save)
+      resume->save(step + 1, *gr, SABest);
+    //t *= alpha;
+  }
+  if (SABest.betterThanInitial())
+  {
+    SABest.copyGraph(gr);
+    int finalCr = SABest.val();
+    assert(finalCr <= crCnt);
+    assert(finalCr == Tools::countCrossingNumberFast(*gr));
+    cout << endl << "SimAnneal before BBgreedy: Last value: " << crCnt
+         << ", best value (will be used): " << finalCr << endl;
+    crCnt = finalCr;
+  }
+  else
+  {
+    cout << endl << "SimAnneal before BBgreedy: Last value (will be used): "
+         << crCnt << ", best value is the initial (" << SABest.val() << ")"
+         << endl;
+  }
+  crCnt = BBGreedy(gr, best);
+  cout << "SimAnneal: " << crCnt << endl;
+  return crCnt;
+}
+
+/**
+ * Replaces the vertex order of gr by a random one (10*n random moves of single vertices) and places
+ * the edges by lenPages.
+ */
+void Strategies::randomRestart(Graph *gr, std::mt19937 &mt)
+{
+  Stats::Timer timer(Stats::RandomRestart);
+  int n = static_cast<int>(gr->v.size());
+  std::uniform_int_distribution<int> vertexDistrib(0, n - 1);
+  for (int j = 0; j < 10 * n; j++)
+  {
+    int v1 = vertexDistrib(mt);
+    int v2 = vertexDistrib(mt);
+    if (v1 == v2)
+      continue;
+    Tools::moveVertex(gr, v1, v2);
+  }
+  int crTmp = Tools::countCrossingNumberFast(*gr);
+  Tools::restartEdges(gr, crTmp, Tools::lenPages);
+}
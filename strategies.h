@@ -0,0 +1,56 @@
+/**
+ * The strategies for minimizing the number of crossings used by the solver.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_STRATEGIES_H_
+#define BOOK_EMBEDDER_STRATEGIES_H_
+
+#include <functional>
+#include <random>
+
+#include "graph.h"
+#include "bestfound.h"
+#include "crossingstate.h"
+
+/**
+ * Lets a run of simAnneal be saved and continued: the run skips the first step steps of the schedule,
+ * starts with localBest as its best drawing (if localBestVal is not -1) and calls save (if set)
+ * after every step.
+ */
+struct AnnealResume
+{
+  int step = 0;
+  int localBestVal = -1;
+  Graph localBest;
+  std::function<void(int step, const Graph &gr, const BestFound &localBest)> save;
+};
+
+/**
+ * Every strategy improves the drawing gr in place and reports every improvement to best.
+ * The strategies do not share any state, so they may run in parallel on different graphs
+ * (each with its own random generator) as long as best is thread-safe.
+ */
+class Strategies
+{
+ public:
+  static void BaurBrandes(Graph *gr, BestFound *best);
+
+  static int BBGreedy(Graph *gr, BestFound *best);
+
+  static int GreedyBB(Graph *gr, BestFound *best);
+
+  static int annealStep(Graph *gr, CrossingState *state, double t, BestFound *best,
+                        BestFound *localBest, std::mt19937 &mt);
+
+  static int simAnneal(Graph *gr, double t0, BestFound *best, std::mt19937 &mt,
+                       double seconds = 0, AnnealResume *resume = nullptr);
+
+  static void randomRestart(Graph *gr, std::mt19937 &mt);
+};
+
+#endif
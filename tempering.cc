@@ -0,0 +1,112 @@
+/**
+ * Parallel tempering (replica exchange) version of the simulated annealing.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#include "tempering.h"
+#include "deadline.h"
+#include "stats.h"
+#include "strategies.h"
+#include "threadpool.h"
+#include "tools.h"
+
+using std::vector;
+using std::cout;
+using std::endl;
+
+ReplicaExchange::ReplicaExchange(int replicaCnt, int threadCnt, double tMax,
+                                 double tMin, int roundCnt)
+    : threadCnt_(threadCnt),
+      roundCnt_(roundCnt)
+{
+  assert(replicaCnt >= 1);
+  for (int k = 0; k < replicaCnt; k++)
+  {
+    double frac = (replicaCnt == 1 ? 1.0 : k / (replicaCnt - 1.0));
+    temps_.push_back(tMax * std::pow(tMin / tMax, frac));
+  }
+}
+
+/**
+ * Tries to exchange the replicas at temperatures k and k+1 for all k of the given parity.
+ * The exchange is accepted with probability min(1, exp((1/t_k - 1/t_{k+1}) * (cr_k - cr_{k+1}))),
+ * which keeps every replica sampling from the distribution of its temperature.
+ * Returns the number of accepted exchanges.
+ */
+int ReplicaExchange::exchange(int parity, std::mt19937 &mt)
+{
+  std::uniform_real_distribution<double> zeroOneDistrib(0, 1);
+  int accepted = 0;
+  for (int k = parity; k + 1 < static_cast<int>(temps_.size()); k += 2)
+  {
+    const Replica &hot = *replicas_[atTemp_[k]];
+    const Replica &cold = *replicas_[atTemp_[k + 1]];
+    double delta = (1 / temps_[k] - 1 / temps_[k + 1])
+        * (hot.crCnt - cold.crCnt);
+    if (delta >= 0 || zeroOneDistrib(mt) < ::exp(delta))
+    {
+      std::swap(atTemp_[k], atTemp_[k + 1]);
+      accepted++;
+    }
+  }
+  return accepted;
+}
+
+/**
+ * All the replicas start from gr. When the rounds are over (or a drawing without crossings is found),
+ * the best drawing seen by any replica is polished by BBGreedy and stored to gr.
+ * The exchanges use mt; every replica has its own generator seeded from mt.
+ * Returns the final crossing number.
+ */
+int ReplicaExchange::run(Graph *gr, BestFound *best, std::mt19937 &mt)
+{
+  Stats::Timer timer(Stats::ReplicaExchange);
+  replicas_.clear();
+  atTemp_.clear();
+  for (std::size_t k = 0; k < temps_.size(); k++)
+  {
+    replicas_.push_back(std::unique_ptr<Replica>(new Replica(*gr, mt())));
+    replicas_.back()->crCnt = replicas_.back()->state.total();
+    atTemp_.push_back(k);
+  }
+
+  BestFound PTBest("", *gr);
+  PTBest.restart();
+  ThreadPool pool(threadCnt_);
+  int tried = 0;
+  int accepted = 0;
+  for (int round = 0; round < roundCnt_ && PTBest.val() != 0 && !Deadline::passed(); round++)
+  {
+    for (std::size_t k = 0; k < temps_.size(); k++)
+    {
+      Replica *rep = replicas_[atTemp_[k]].get();
+      double t = temps_[k];
+      pool.submit([rep, t, best, &PTBest]()
+      {
+        rep->crCnt = Strategies::annealStep(&rep->gr, &rep->state, t, best,
+                                            &PTBest, rep->mt);
+      });
+    }
+    pool.wait();
+    tried += (temps_.size() - round % 2) / 2;
+    accepted += exchange(round % 2, mt);
+  }
+
+  cout << endl << "ReplicaExchange: " << temps_.size() << " replicas, "
+       << accepted << " of " << tried << " exchanges accepted, best value: "
+       << PTBest.val() << endl;
+  if (PTBest.betterThanInitial())
+    PTBest.copyGraph(gr);
+  int crCnt = Strategies::BBGreedy(gr, best);
+  cout << "ReplicaExchange: " << crCnt << endl;
+  return crCnt;
+}
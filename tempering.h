@@ -0,0 +1,60 @@
+/**
+ * Parallel tempering (replica exchange) version of the simulated annealing.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_TEMPERING_H_
+#define BOOK_EMBEDDER_TEMPERING_H_
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "graph.h"
+#include "bestfound.h"
+#include "crossingstate.h"
+
+/**
+ * Several replicas of the drawing, each at a fixed temperature from a geometric ladder between
+ * tMax and tMin. In every round, each replica makes one Strategies::annealStep at its temperature
+ * (the replicas run in parallel), and then the replicas at neighboring temperatures try to exchange
+ * their temperatures.
+ */
+class ReplicaExchange
+{
+ public:
+  ReplicaExchange(int replicaCnt, int threadCnt, double tMax = 64,
+                  double tMin = 0.2, int roundCnt = 980);
+
+  int run(Graph *gr, BestFound *best, std::mt19937 &mt);
+
+ private:
+  struct Replica
+  {
+    Replica(const Graph &start, std::uint32_t seed)
+        : gr(start),
+          state(gr),
+          mt(seed)
+    {
+    }
+    Graph gr;
+    CrossingState state;
+    std::mt19937 mt;
+    int crCnt = 0;
+  };
+
+  int threadCnt_;
+  int roundCnt_;
+  std::vector<double> temps_;  ///< The ladder, from the hottest.
+  std::vector<std::unique_ptr<Replica> > replicas_;
+  std::vector<int> atTemp_;  ///< atTemp_[k] is the replica currently at temperature temps_[k].
+
+  int exchange(int parity, std::mt19937 &mt);
+};
+
+#endif
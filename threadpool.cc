@@ -0,0 +1,200 @@
+/**
+ * Pools of worker threads executing submitted tasks.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(int threadCnt)
+{
+  for (int i = 0; i < threadCnt; i++)
+    workers_.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  taskAvailable_.notify_all();
+  for (std::thread &worker : workers_)
+    worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  taskAvailable_.notify_one();
+}
+
+/**
+ * Waits until all the submitted tasks (including those submitted by the tasks themselves) finish.
+ */
+void ThreadPool::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  allDone_.wait(lock, [this]
+  {
+    return tasks_.empty() && running_ == 0;
+  });
+}
+
+void ThreadPool::workerLoop()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    taskAvailable_.wait(lock, [this]
+    {
+      return stopping_ || !tasks_.empty();
+    });
+    if (tasks_.empty())
+      return;  // stopping
+    std::function<void()> task = std::move(tasks_.front());
+    tasks_.pop_front();
+    running_++;
+    lock.unlock();
+    task();
+    lock.lock();
+    running_--;
+    if (tasks_.empty() && running_ == 0)
+      allDone_.notify_all();
+  }
+}
+
+namespace
+{
+
+/**
+ * The pool whose worker is the current thread and the index of the worker (nullptr and -1 outside
+ * of the workers).
+ */
+thread_local WorkStealingPool *currentPool = nullptr;
+thread_local int currentWorker = -1;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(int threadCnt)
+{
+  for (int i = 0; i < threadCnt; i++)
+    queues_.push_back(std::unique_ptr<Queue>(new Queue()));
+  for (int i = 0; i < threadCnt; i++)
+    workers_.push_back(std::thread(&WorkStealingPool::workerLoop, this, i));
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  taskAvailable_.notify_all();
+  for (std::thread &worker : workers_)
+    worker.join();
+}
+
+void WorkStealingPool::submit(std::function<void()> task)
+{
+  int q;
+  if (currentPool == this)
+    q = currentWorker;
+  else
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    q = nextQueue_;
+    nextQueue_ = (nextQueue_ + 1) % threadCnt();
+  }
+  {
+    std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+    queues_[q]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_++;
+    unfinished_++;
+  }
+  taskAvailable_.notify_one();
+}
+
+/**
+ * Waits until all the submitted tasks (including those submitted by the tasks themselves) finish.
+ */
+void WorkStealingPool::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  allDone_.wait(lock, [this]
+  {
+    return unfinished_ == 0;
+  });
+}
+
+/**
+ * Takes the newest task of the worker, or else the oldest task of the first other worker with one,
+ * starting from the next worker. Returns false if all the deques are empty.
+ */
+bool WorkStealingPool::take(int worker, std::function<void()> *task)
+{
+  for (int k = 0; k < threadCnt(); k++)
+  {
+    Queue &queue = *queues_[(worker + k) % threadCnt()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+      continue;
+    if (k == 0)
+    {
+      *task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+    else
+    {
+      *task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      stealCnt_++;
+    }
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::workerLoop(int worker)
+{
+  currentPool = this;
+  currentWorker = worker;
+  std::function<void()> task;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // A task is counted in queued_ only after it is in a deque, so take finds it (or another worker
+      // has already taken it and is about to decrease queued_).
+      taskAvailable_.wait(lock, [this]
+      {
+        return stopping_ || queued_ > 0;
+      });
+      if (queued_ == 0)
+        return;  // stopping
+    }
+    if (!take(worker, &task))
+      continue;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queued_--;
+    }
+    task();
+    task = nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--unfinished_ == 0)
+      allDone_.notify_all();
+  }
+}
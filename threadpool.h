@@ -0,0 +1,112 @@
+/**
+ * Pools of worker threads executing submitted tasks.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_THREADPOOL_H_
+#define BOOK_EMBEDDER_THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Tasks are started in the order of submission. The destructor waits for all the tasks.
+ */
+class ThreadPool
+{
+ public:
+  ThreadPool(int threadCnt);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &other) = delete;
+  ThreadPool& operator=(const ThreadPool &other) = delete;
+
+  void submit(std::function<void()> task);
+
+  void wait();
+
+  int threadCnt() const
+  {
+    return static_cast<int>(workers_.size());
+  }
+
+ private:
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()> > tasks_;
+  std::mutex mutex_;
+  std::condition_variable taskAvailable_;
+  std::condition_variable allDone_;
+  int running_ = 0;
+  bool stopping_ = false;
+
+  void workerLoop();
+};
+
+/**
+ * Every worker has its own deque of tasks. A task submitted by a worker goes to the back of the deque
+ * of that worker, which takes its tasks from the back (the newest first). A worker with an empty deque
+ * steals from the front (the oldest task) of the deques of the others. Tasks submitted from outside
+ * the pool are spread over the deques round robin. The destructor waits for all the tasks.
+ */
+class WorkStealingPool
+{
+ public:
+  WorkStealingPool(int threadCnt);
+
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &other) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool &other) = delete;
+
+  void submit(std::function<void()> task);
+
+  void wait();
+
+  int threadCnt() const
+  {
+    return static_cast<int>(workers_.size());
+  }
+
+  /**
+   * The number of tasks taken from the deque of another worker so far.
+   */
+  long long stealCnt() const
+  {
+    return stealCnt_;
+  }
+
+ private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()> > tasks;
+  };
+
+  std::vector<std::thread> workers_;
+  std::vector<std::unique_ptr<Queue> > queues_;
+  std::mutex mutex_;  ///< Guards queued_, unfinished_, nextQueue_ and stopping_.
+  std::condition_variable taskAvailable_;
+  std::condition_variable allDone_;
+  int queued_ = 0;  ///< Tasks in the deques.
+  int unfinished_ = 0;  ///< Tasks in the deques or running.
+  int nextQueue_ = 0;
+  bool stopping_ = false;
+  std::atomic<long long> stealCnt_ { 0 };
+
+  bool take(int worker, std::function<void()> *task);
+
+  void workerLoop(int worker);
+};
+
+#endif
@@ -1,9 +1,17 @@
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <random>
+#include <thread>
 
 #include "tools.h"
+#include "conflictmatrix.h"
+#include "deadline.h"
+#include "fenwick.h"
+#include "pagecostcache.h"
+#include "spankernels.h"
+#include "stats.h"
 
 using std::string;
 using std::vector;
@@ -11,6 +19,40 @@ using std::cout;
 using std::cerr;
 using std::endl;
 
+int Tools::evalThreads_ = 1;
+
+/**
+ * Returns the sum of rangeSum(beg, end) over a partition of 0..cnt-1 into ranges. If work (the estimated
+ * cost of the whole computation) is large enough and more evaluation threads are allowed, the ranges are
+ * taken dynamically by evalThreads() threads (the calling thread is one of them), so rangeSum must be
+ * safe to call concurrently for disjoint ranges.
+ */
+int Tools::parallelSum(int cnt, long long work,
+                       const std::function<int(int, int)> &rangeSum)
+{
+  int threadCnt = std::min(evalThreads_, cnt);
+  if (threadCnt <= 1 || work < minParallelWork)
+    return rangeSum(0, cnt);
+
+  int grain = std::max(1, cnt / (8 * threadCnt));
+  std::atomic<int> next(0);
+  std::atomic<int> result(0);
+  auto worker = [&]()
+  {
+    int sum = 0;
+    for (int beg = next.fetch_add(grain); beg < cnt; beg = next.fetch_add(grain))
+      sum += rangeSum(beg, std::min(cnt, beg + grain));
+    result += sum;
+  };
+  vector<std::thread> helpers;
+  for (int i = 1; i < threadCnt; i++)
+    helpers.push_back(std::thread(worker));
+  worker();
+  for (std::thread &th : helpers)
+    th.join();
+  return result;
+}
+
 bool Tools::doEdgesCross(const Edge &e1, const Edge &e2)
 {
   if (e1.p != e2.p)
@@ -28,6 +70,7 @@ bool Tools::doEdgesCross(const Edge &e1, const Edge &e2)
 
 /**
  * Counts crossings of ed with the other edges of gr.
+ * Only the edges on the page of ed are visited.
  * Time O(m), but faster if ed is short.
  */
 int Tools::countEdgeCrossings(const Graph &gr, const Edge &ed)
@@ -38,10 +81,8 @@ int Tools::countEdgeCrossings(const Graph &gr, const Edge &ed)
   int v2 = std::max(ed.v1, ed.v2);
 
   for (int id2 = v1 + 1; id2 < v2; id2++)
-    for (const Edge *ed2 : gr.v[id2].neighs)
+    for (const Edge *ed2 : gr.v[id2].onPage(ed.p))
     {
-      if (ed.p != ed2->p)
-        continue;
       int e2V2 = ed2->getOtherEnd(id2);
       assert(doEdgesCross(ed, *ed2) == (e2V2 < v1 || e2V2 > v2));
       if (e2V2 < v1 || e2V2 > v2)
@@ -66,19 +107,209 @@ int Tools::countEdgesFromVertexCrossings(const Graph &gr, const Vertex &ver)
  */
 int Tools::countCrossingNumber(const Graph &gr)
 {
-  int result = 0;
-  for (const Edge &ed : gr.e)
-    result += countEdgeCrossings(gr, ed);
+  long long m = gr.e.size();
+  int result = parallelSum(gr.e.size(), m * m, [&gr](int beg, int end)
+  {
+    int sum = 0;
+    for (int i = beg; i < end; i++)
+      sum += countEdgeCrossings(gr, gr.e[i]);
+    return sum;
+  });
   result >>= 1;  // every crossing was counted twice
   return result;
 }
 
+/**
+ * Sorts the edges of gr into buckets by page (pageBeg[p+1]..pageBeg[p+2]-1 is the bucket of page p,
+ * bucket 0 holds the unassigned edges with page -1).
+ * Within a bucket, the edges are sorted by the end-point from[], either increasingly by
+ * the left end-point (if leftToRight), or decreasingly by the right end-point; to[] is the other end-point.
+ * Edges whose end-points coincide are omitted.
+ * Time O(n + m).
+ */
+void Tools::sortEdgesByPage(const Graph &gr, bool leftToRight,
+                            vector<int> &pageBeg, vector<int> &from,
+                            vector<int> &to, vector<int> *edgeIdx)
+{
+  int n = static_cast<int>(gr.v.size());
+  int m = static_cast<int>(gr.e.size());
+
+  // Counting sort; going through the vertices in order makes each bucket sorted by from[].
+  pageBeg.assign(gr.p + 2, 0);
+  for (const Edge &ed : gr.e)
+  {
+    assert(ed.p >= -1 && ed.p < gr.p);
+    if (ed.v1 != ed.v2)
+      pageBeg[ed.p + 2]++;
+  }
+  for (int p = 1; p < gr.p + 2; p++)
+    pageBeg[p] += pageBeg[p - 1];
+  vector<int> fill(pageBeg.begin(), pageBeg.end() - 1);
+  from.resize(m);
+  to.resize(m);
+  if (edgeIdx != nullptr)
+    edgeIdx->resize(m);
+  for (int i = 0; i < n; i++)
+  {
+    int a = (leftToRight ? i : n - 1 - i);
+    for (const Edge *ed : gr.v[a].neighs)
+    {
+      int b = ed->getOtherEnd(a);
+      if (leftToRight ? (b <= a) : (b >= a))
+        continue;
+      int idx = fill[ed->p + 1]++;
+      from[idx] = a;
+      to[idx] = b;
+      if (edgeIdx != nullptr)
+        (*edgeIdx)[idx] = static_cast<int>(ed - &gr.e[0]);
+    }
+  }
+}
+
+/**
+ * The same as sortEdgesByPage for the FlatGraph.
+ * Time O(n + m).
+ */
+void Tools::sortEdgesByPage(const FlatGraph &fg, bool leftToRight,
+                            vector<int> &pageBeg, vector<int> &from,
+                            vector<int> &to, vector<int> *edgeIdx)
+{
+  int n = fg.vertexCnt();
+  int m = fg.edgeCnt();
+
+  pageBeg.assign(fg.p + 2, 0);
+  for (int i = 0; i < m; i++)
+  {
+    assert(fg.ep[i] >= -1 && fg.ep[i] < fg.p);
+    if (fg.ev1[i] != fg.ev2[i])
+      pageBeg[fg.ep[i] + 2]++;
+  }
+  for (int p = 1; p < fg.p + 2; p++)
+    pageBeg[p] += pageBeg[p - 1];
+  vector<int> fill(pageBeg.begin(), pageBeg.end() - 1);
+  from.resize(m);
+  to.resize(m);
+  if (edgeIdx != nullptr)
+    edgeIdx->resize(m);
+  for (int i = 0; i < n; i++)
+  {
+    int a = (leftToRight ? i : n - 1 - i);
+    for (int s = fg.offs[a]; s < fg.offs[a + 1]; s++)
+    {
+      int b = fg.adjOther[s];
+      if (leftToRight ? (b <= a) : (b >= a))
+        continue;
+      int idx = fill[fg.adjPage[s] + 1]++;
+      from[idx] = a;
+      to[idx] = b;
+      if (edgeIdx != nullptr)
+        (*edgeIdx)[idx] = fg.adjEdge[s];
+    }
+  }
+}
+
+/**
+ * Sweeps the buckets of edges sorted by sortEdgesByPage with a Fenwick tree over the to[] end-points.
+ * Every edge gets the crossings with the edges taken before it: those that start strictly before it
+ * (in the sweep direction) and whose to[] end-point lies strictly inside the edge.
+ * If cr is not null, the crossings are also added to cr[edgeIdx[i]].
+ * The pages are independent, so they are swept in parallel if there are more evaluation threads.
+ * Returns the number of the found crossings. Time O(m log n).
+ */
+int Tools::sweepSortedEdges(int n, const vector<int> &pageBeg,
+                            const vector<int> &from, const vector<int> &to,
+                            const vector<int> *edgeIdx, vector<int> *cr)
+{
+  return parallelSum(
+      static_cast<int>(pageBeg.size()) - 1, pageBeg.back(),
+      [&](int beg, int end)
+      { return sweepBuckets(n, pageBeg, from, to, edgeIdx, cr, beg, end);});
+}
+
+/**
+ * sweepSortedEdges restricted to the buckets bucketBeg..bucketEnd-1.
+ */
+int Tools::sweepBuckets(int n, const vector<int> &pageBeg,
+                        const vector<int> &from, const vector<int> &to,
+                        const vector<int> *edgeIdx, vector<int> *cr,
+                        int bucketBeg, int bucketEnd)
+{
+  int result = 0;
+  FenwickTree ends(n);
+  for (int p = bucketBeg; p < bucketEnd; p++)
+  {
+    int groupBeg = pageBeg[p];
+    while (groupBeg < pageBeg[p + 1])
+    {
+      // Edges with the same starting end-point do not cross each other, so they are added together.
+      int groupEnd = groupBeg;
+      while (groupEnd < pageBeg[p + 1] && from[groupEnd] == from[groupBeg])
+        groupEnd++;
+      for (int i = groupBeg; i < groupEnd; i++)
+      {
+        int cnt = ends.sumBetween(std::min(from[i], to[i]),
+                                  std::max(from[i], to[i]));
+        if (cr != nullptr)
+          (*cr)[(*edgeIdx)[i]] += cnt;
+        result += cnt;
+      }
+      for (int i = groupBeg; i < groupEnd; i++)
+        ends.add(to[i], 1);
+      groupBeg = groupEnd;
+    }
+    for (int i = pageBeg[p]; i < pageBeg[p + 1]; i++)
+      ends.add(to[i], -1);
+  }
+  return result;
+}
+
+/**
+ * Gives the same result as countCrossingNumber, but sweeps every page with a Fenwick tree.
+ * Edges of one page are taken by increasing left end-point; an edge crosses exactly those
+ * previously taken edges whose left end-point is strictly smaller and whose right
+ * end-point lies strictly inside the edge.
+ * Edges with unassigned page (-1) are treated as one more page.
+ * Time O(n + m log n).
+ */
+int Tools::countCrossingNumberFast(const Graph &gr)
+{
+  Stats::Timer timer(Stats::CountCrossingsFast);
+  vector<int> pageBeg, left, right;
+  sortEdgesByPage(gr, true, pageBeg, left, right, nullptr);
+  int result = sweepSortedEdges(static_cast<int>(gr.v.size()), pageBeg, left,
+                                right, nullptr, nullptr);
+  assert(result == countCrossingNumber(gr));
+  return result;
+}
+
+/**
+ * Fills cr[i] with the number of crossings of the edge gr.e[i]; returns the crossing number.
+ * Two sweeps as in countCrossingNumberFast: from the left, every edge gets the crossings with edges
+ * starting before it, and from the right, the crossings with edges ending after it.
+ * Time O(n + m log n).
+ */
+int Tools::countCrossingsPerEdge(const Graph &gr, vector<int> &cr)
+{
+  cr.assign(gr.e.size(), 0);
+  vector<int> pageBeg, from, to, edgeIdx;
+  int result = 0;
+  for (int dir = 0; dir < 2; dir++)
+  {
+    sortEdgesByPage(gr, dir == 0, pageBeg, from, to, &edgeIdx);
+    result += sweepSortedEdges(static_cast<int>(gr.v.size()), pageBeg, from,
+                               to, &edgeIdx, &cr);
+  }
+  result >>= 1;  // every crossing was counted in both sweeps
+  return result;
+}
+
 /**
  * Counts the change in the number of crossings if we swap v1 and v1+1.
  * Positive return value ... the crossing number increases by the swap.
  * Note that the only crossings that may change are those where one edge has v1 as
  * one of its endpoints and the other edge has v1+1 as one of its end-points.
- * O(deg(v1)*deg(v1+1)) ~ O(m^2/n^2)
+ * Only pairs of edges on the same page are visited.
+ * O(pageCnt + sum over pages of deg_p(v1)*deg_p(v1+1)) ~ O(m^2/(n^2*pageCnt))
  */
 int Tools::countCrossingChangeIfNeighborsSwapped(const Graph &gr, int v1)
 {
@@ -86,30 +317,29 @@ int Tools::countCrossingChangeIfNeighborsSwapped(const Graph &gr, int v1)
   assert(v1 + 1 < static_cast<int>(gr.v.size()));
   const Vertex &ver1 = gr.v[v1];
   const Vertex &ver2 = gr.v[v1 + 1];
-  for (const Edge *ed1 : ver1.neighs)
-    for (const Edge *ed2 : ver2.neighs)
-    {
-      if (ed1->p != ed2->p)
-        continue;
-      int ed1v2 = ed1->getOtherEnd(v1);
-      int ed2v2 = ed2->getOtherEnd(v1 + 1);
-      if (ed1v2 == ed2v2 || ed1v2 == v1 + 1 || ed2v2 == v1)
-        continue;  // they share an endpoint -> they never cross
-      // they do not share an endpoint -> they cross either before or after the swap
-      bool crossBefore = false;
-      if (ed1v2 > v1 + 1 && (ed2v2 < v1 || ed2v2 > ed1v2))
-        crossBefore = true;
-      else if (ed1v2 < v1 && ed2v2 < v1 && ed2v2 > ed1v2)
-        crossBefore = true;
-      result += (crossBefore ? -1 : 1);
-    }
+  for (int p = -1; p < gr.p; p++)
+    for (const Edge *ed1 : ver1.onPage(p))
+      for (const Edge *ed2 : ver2.onPage(p))
+      {
+        int ed1v2 = ed1->getOtherEnd(v1);
+        int ed2v2 = ed2->getOtherEnd(v1 + 1);
+        if (ed1v2 == ed2v2 || ed1v2 == v1 + 1 || ed2v2 == v1)
+          continue;  // they share an endpoint -> they never cross
+        // they do not share an endpoint -> they cross either before or after the swap
+        bool crossBefore = false;
+        if (ed1v2 > v1 + 1 && (ed2v2 < v1 || ed2v2 > ed1v2))
+          crossBefore = true;
+        else if (ed1v2 < v1 && ed2v2 < v1 && ed2v2 > ed1v2)
+          crossBefore = true;
+        result += (crossBefore ? -1 : 1);
+      }
   return result;
 }
 
 /**
  * Counts crossings between pairs of edges, where one edge has v1 as one of its end-points
  * and the other edge has v1+1 as one of its end-points.
- * O(deg(v1)*deg(v1+1)) ~ O(m^2/n^2)
+ * O(pageCnt + sum over pages of deg_p(v1)*deg_p(v1+1)) ~ O(m^2/(n^2*pageCnt))
  */
 int Tools::countCrossingsOfEdgesFromNeighbors(const Graph &gr, int v1)
 {
@@ -117,18 +347,17 @@ int Tools::countCrossingsOfEdgesFromNeighbors(const Graph &gr, int v1)
   assert(v1 + 1 < static_cast<int>(gr.v.size()));
   const Vertex &ver1 = gr.v[v1];
   const Vertex &ver2 = gr.v[v1 + 1];
-  for (const Edge *ed1 : ver1.neighs)
-    for (const Edge *ed2 : ver2.neighs)
-    {
-      if (ed1->p != ed2->p)
-        continue;
-      int ed1v2 = ed1->getOtherEnd(v1);
-      int ed2v2 = ed2->getOtherEnd(v1 + 1);
-      if (ed1v2 > v1 + 1 && (ed2v2 < v1 || ed2v2 > ed1v2))
-        result++;
-      else if (ed1v2 < v1 && ed2v2 < v1 && ed2v2 > ed1v2)
-        result++;
-    }
+  for (int p = -1; p < gr.p; p++)
+    for (const Edge *ed1 : ver1.onPage(p))
+      for (const Edge *ed2 : ver2.onPage(p))
+      {
+        int ed1v2 = ed1->getOtherEnd(v1);
+        int ed2v2 = ed2->getOtherEnd(v1 + 1);
+        if (ed1v2 > v1 + 1 && (ed2v2 < v1 || ed2v2 > ed1v2))
+          result++;
+        else if (ed1v2 < v1 && ed2v2 < v1 && ed2v2 > ed1v2)
+          result++;
+      }
   return result;
 }
 
@@ -142,13 +371,9 @@ void Tools::countEdgesVertexCrossingsImpl(const Graph &gr, int v1,
 {
   const Vertex &ver1 = gr.v[v1];
   for (Edge &ed1 : eList)
-    for (const Edge *ed2 : ver1.neighs)
-    {
-      if (ed1.p != ed2->p)
-        continue;
+    for (const Edge *ed2 : ver1.onPage(ed1.p))
       if (doEdgesCross(ed1, *ed2))
         ed1.cr += factor;
-    }
 }
 
 /**
@@ -177,55 +402,88 @@ void Tools::addEdgesVertexCrossings(const Graph &gr, int v1,
  */
 void Tools::countEdgesGraphCrossings(const Graph &gr, vector<Edge> &eList)
 {
-  for (Edge &ed1 : eList)
-    for (const Edge &ed2 : gr.e)
-    {
-      if (ed1.p != ed2.p)
-        continue;
-      if (doEdgesCross(ed1, ed2))
-        ed1.cr++;
-    }
+  long long work = static_cast<long long>(eList.size()) * gr.e.size();
+  parallelSum(eList.size(), work, [&gr, &eList](int beg, int end)
+  {
+    for (int i = beg; i < end; i++)
+      for (const Edge &ed2 : gr.e)
+      {
+        if (eList[i].p != ed2.p)
+          continue;
+        if (doEdgesCross(eList[i], ed2))
+          eList[i].cr++;
+      }
+    return 0;
+  });
 }
 
 /**
  * Move a single vertex from vOld to vNew.
- * Time: O(m)
+ * Only the vertices between vOld and vNew (inclusive) are shifted. If the window is short compared to
+ * the whole graph, only the edges incident to it are updated, otherwise all edges are remapped in one
+ * sequential pass (which is faster than following the neighbor lists of most of the vertices).
+ * Time: O(|vOld - vNew| + min(m, sum of degrees of the shifted vertices))
  */
 void Tools::moveVertex(Graph *gr, int vOld, int vNew)
 {
   if (vOld == vNew)
     return;
-  vector<int> newPos;
+  int lo = std::min(vOld, vNew);
+  int hi = std::max(vOld, vNew);
   int n = static_cast<int>(gr->v.size());
-  for (int i = 0; i < n; i++)
-  {
-    int nPos = i;
-    if (i > vOld)
-      nPos--;  // vertices after the old position move back
-    if (nPos >= vNew)
-      nPos++;  // vertices on or after the new position move forward
-    if (i == vOld)
-      nPos = vNew;  // the moved vertex
-    newPos.push_back(nPos);
-  }
-  vector<Vertex> newVerVector(n, Vertex(-1));
-  for (int i = 0; i < n; i++)
-    newVerVector[newPos[i]] = std::move(gr->v[i]);
-  gr->v = std::move(newVerVector);
 
-  for (Edge &ed : gr->e)
+  if (static_cast<long long>(hi - lo + 1) * moveVertexWindowFactor < n)
   {
-    ed.v1 = newPos[ed.v1];
-    ed.v2 = newPos[ed.v2];
+    // The end-points at vOld are marked by -1, then the other vertices of the window are shifted
+    // by one in the direction of vOld, starting next to vOld, so that an already shifted end-point
+    // never matches a vertex that is processed later.
+    for (Edge *ed : gr->v[vOld].neighs)
+    {
+      if (ed->v1 == vOld)
+        ed->v1 = -1;
+      if (ed->v2 == vOld)
+        ed->v2 = -1;
+    }
+    int shift = (vOld < vNew ? -1 : 1);
+    for (int i = vOld - shift; i != vNew - shift; i -= shift)
+      for (Edge *ed : gr->v[i].neighs)
+      {
+        if (ed->v1 == i)
+          ed->v1 = i + shift;
+        if (ed->v2 == i)
+          ed->v2 = i + shift;
+      }
+    for (Edge *ed : gr->v[vOld].neighs)
+    {
+      if (ed->v1 == -1)
+        ed->v1 = vNew;
+      if (ed->v2 == -1)
+        ed->v2 = vNew;
+    }
   }
-
-  for (Vertex &ver : gr->v)
-    if (ver.id == -1)
+  else
+  {
+    int shift = (vOld < vNew ? -1 : 1);
+    unsigned width = static_cast<unsigned>(hi - lo);
+    // Written without branches, the end-points in the window are random and would be mispredicted.
+    auto newPos = [=](int x)
+    {
+      int shifted = x + (static_cast<unsigned>(x - lo) <= width ? shift : 0);
+      return (x == vOld ? vNew : shifted);
+    };
+    for (Edge &ed : gr->e)
     {
-      std::cerr << "Vertex " << std::distance(&(gr->v[0]), &ver)
-                << " has id -1." << endl;
-      exit(0);
+      ed.v1 = newPos(ed.v1);
+      ed.v2 = newPos(ed.v2);
     }
+  }
+
+  auto first = gr->v.begin() + lo;
+  auto last = gr->v.begin() + hi + 1;
+  if (vOld < vNew)
+    std::rotate(first, first + 1, last);
+  else
+    std::rotate(first, last - 1, last);
 }
 
 /**
@@ -257,6 +515,70 @@ void Tools::swapVertices(Graph *gr, int vA, int vB)
   std::swap(gr->v[vA], gr->v[vB]);
 }
 
+/**
+ * The average cost of a scan of the span of an edge on one page (as in countEdgeCrossings): the length
+ * of the span plus the edges at the vertices inside it that are on the page (taken as 1/p of them).
+ * Used to decide whether the crossings are worth precomputing.
+ * Time O(n + m).
+ */
+double Tools::averageSpanScan(const Graph &gr)
+{
+  if (gr.e.empty() || gr.p <= 0)
+    return 0;
+  int n = static_cast<int>(gr.v.size());
+  vector<long long> degPrefix(n + 1, 0);
+  for (int i = 0; i < n; i++)
+    degPrefix[i + 1] = degPrefix[i] + gr.v[i].neighs.size();
+  double scanSum = 0;
+  for (const Edge &ed : gr.e)
+  {
+    int lo = std::min(ed.v1, ed.v2);
+    int hi = std::max(ed.v1, ed.v2);
+    scanSum += (hi - lo) + static_cast<double>(degPrefix[hi] - degPrefix[lo + 1]) / gr.p;
+  }
+  return scanSum / gr.e.size();
+}
+
+/**
+ * Stores the drawing gr as the vertex ids in the order of the drawing and the pages of the edges
+ * (in the order of gr.e). The vectors are resized, so their memory is reused.
+ * Time O(n + m).
+ */
+void Tools::storeDrawing(const Graph &gr, vector<int> *ids, vector<int> *pages)
+{
+  ids->resize(gr.v.size());
+  for (unsigned i = 0; i < gr.v.size(); i++)
+    (*ids)[i] = gr.v[i].id;
+  pages->resize(gr.e.size());
+  for (unsigned i = 0; i < gr.e.size(); i++)
+    (*pages)[i] = gr.e[i].p;
+}
+
+/**
+ * Builds to target the drawing of origGr stored by storeDrawing; ids must be a permutation of the ids
+ * of origGr and the pages must be in range.
+ * Time O(n + m).
+ */
+void Tools::buildDrawing(const Graph &origGr, const vector<int> &ids, const vector<int> &pages,
+                         Graph *target)
+{
+  int n = static_cast<int>(ids.size());
+  vector<int> posOfId(n);
+  for (int i = 0; i < n; i++)
+    posOfId[ids[i]] = i;
+  target->p = origGr.p;
+  target->v.clear();
+  for (int id : ids)
+    target->v.push_back(Vertex(id));
+  target->e.clear();
+  for (unsigned i = 0; i < origGr.e.size(); i++)
+  {
+    const Edge &ed = origGr.e[i];
+    target->e.push_back(Edge(posOfId[origGr.v[ed.v1].id], posOfId[origGr.v[ed.v2].id], pages[i]));
+  }
+  target->restoreNeighs();
+}
+
 /**
  * Finds the best page for the edge ed.
  * Crossings with edges with unassigned page (their page is negative) are ignored.
@@ -272,10 +594,8 @@ bool Tools::greedyEdgePage(Graph *gr, Edge *ed)
   vector<unsigned> pageValue(gr->p, 0);
 
   for (int id2 = v1 + 1; id2 < v2; id2++)
-    for (const Edge *ed2 : gr->v[id2].neighs)
+    for (const Edge *ed2 : gr->v[id2].onAllPages())
     {
-      if (ed2->p < 0)
-        continue;
       int e2V2 = ed2->getOtherEnd(id2);
       assert(
           doEdgesCross(*ed, *ed2) == (ed->p == ed2->p && ( e2V2 < v1 || e2V2 > v2)));
@@ -294,7 +614,7 @@ bool Tools::greedyEdgePage(Graph *gr, Edge *ed)
 
   if (best < 0)  // may happen if there is only one page
     return false;
-  ed->p = best;
+  gr->setPage(ed, best);
   return (origPage < 0 || pageValue[ed->p] < pageValue[origPage]);
 }
 
@@ -308,58 +628,141 @@ void Tools::greedyAtVertex(Graph *gr, int v)
     greedyEdgePage(gr, ed);
 }
 
+/**
+ * The same as moveVertex, but the move is recorded to log.
+ */
+void Tools::moveVertex(Graph *gr, int vOld, int vNew, UndoLog *log)
+{
+  log->recordMove(vOld, vNew);
+  moveVertex(gr, vOld, vNew);
+}
+
+/**
+ * The same as greedyAtVertex, but the changed pages are recorded to log.
+ */
+void Tools::greedyAtVertex(Graph *gr, int v, UndoLog *log)
+{
+  for (Edge *ed : gr->v[v].neighs)
+  {
+    int origPage = ed->p;
+    greedyEdgePage(gr, ed);
+    if (ed->p != origPage)
+      log->recordPage(static_cast<int>(ed - &gr->e[0]), origPage);
+  }
+}
+
+/**
+ * Undoes the changes recorded in log, from the last one, and clears the log.
+ * Time: the same as the recorded changes; a page change is undone by Graph::setPage, which searches
+ * the page buckets of both end-points, so it takes O(degree) (plus O(p) to shift the buckets).
+ */
+void Tools::rollback(Graph *gr, UndoLog *log)
+{
+  for (auto it = log->entries_.rbegin(); it != log->entries_.rend(); ++it)
+  {
+    if (it->ed >= 0)
+      gr->setPage(&gr->e[it->ed], it->a);
+    else
+      moveVertex(gr, it->b, it->a);
+  }
+  log->clear();
+}
+
 /**
  * Iterates until the iteration that does not improve.
  * In each iteration, finds the best page for every edge of G.
  * The edges are taken in the order that was given by the input file.
- * Time O(iterCnt * m * m), but faster if edges are short (one of the m's is then smaller).
+ * The costs of the pages are counted on the bitsets of a ConflictMatrix for small graphs, otherwise
+ * they are kept in a PageCostCache (if it fits), so only the edges that change their page are scanned.
+ * Time O(iterCnt * m * m), but faster if edges are short (one of the m's is then smaller);
+ * with the matrix O(m*m/64 + iterCnt*m*p*m/64), with the cache
+ * O(m*p*log n + iterCnt*m*p + (number of page changes) * m).
  */
 void Tools::greedyPages(Graph *gr)
 {
+  Stats::Timer timer(Stats::GreedyPages);
+  ConflictMatrix conflicts;
+  bool bitsets = ConflictMatrix::fits(*gr);
+  PageCostCache cache;
+  bool cached = !bitsets && PageCostCache::fits(*gr);
+  if (bitsets)
+    conflicts.update(*gr);
+  else if (cached)
+    cache.build(*gr);
   bool improved = true;
-  while (improved)
+  while (improved && !Deadline::passed())
   {
     improved = false;
     for (Edge &ed : gr->e)
-      if (greedyEdgePage(gr, &ed))
+    {
+      if (Deadline::passed())
+        return;
+      if (bitsets ? conflicts.greedyEdgePage(gr, &ed)
+          : cached ? cache.greedyEdgePage(gr, &ed) : greedyEdgePage(gr, &ed))
         improved = true;
+    }
   }
 }
 
 /**
  * The same as greedyPages, but takes the edges in the order of increasing length.
- * Time O(iterCnt * m * m), but faster if edges are short (one of the m's is then smaller).
+ * Time as in greedyPages.
  */
 void Tools::lenPages(Graph *gr)
 {
+  Stats::Timer timer(Stats::LenPages);
   vector<Edge *> eSorted;
   for (Edge &e : gr->e)
     eSorted.push_back(&e);
   std::sort(eSorted.begin(), eSorted.end(), EdgeLengthComparer());
+  ConflictMatrix conflicts;
+  bool bitsets = ConflictMatrix::fits(*gr);
+  PageCostCache cache;
+  bool cached = !bitsets && PageCostCache::fits(*gr);
+  if (bitsets)
+    conflicts.update(*gr);
+  else if (cached)
+    cache.build(*gr);
   bool improved = true;
-  while (improved)
+  while (improved && !Deadline::passed())
   {
     improved = false;
     for (Edge *ed : eSorted)
-      if (greedyEdgePage(gr, ed))
+    {
+      if (Deadline::passed())
+        return;
+      if (bitsets ? conflicts.greedyEdgePage(gr, ed)
+          : cached ? cache.greedyEdgePage(gr, ed) : greedyEdgePage(gr, ed))
         improved = true;
+    }
   }
 }
 
 /**
  * Set pages of all edges to -1 and then calls the placer function.
- * If the result is worse than the initial, gr is not changed.
+ * If the result is worse than the initial or the deadline passed, gr is not changed.
+ * The placer may change only the pages, so only the pages are backed up.
+ * The pages are reset and restored all at once, with one rebuild of the page index.
+ * Time O(n + m) + the placer + O(m log n) for the count.
  */
 int Tools::restartEdges(Graph *gr, int prevCr, void (*placer)(Graph *gr))
 {
-  Graph grBck = *gr;
-  for (Edge &e : gr->e)
-    e.p = -1;
+  Stats::Timer timer(Stats::RestartEdges);
+  vector<int> pagesBck(gr->e.size());
+  for (unsigned i = 0; i < gr->e.size(); i++)
+  {
+    pagesBck[i] = gr->e[i].p;
+    gr->e[i].p = -1;
+  }
+  gr->restoreNeighs();
   placer(gr);
-  int newCr = countCrossingNumber(*gr);
-  if (prevCr < newCr)
+  int newCr = countCrossingNumberFast(*gr);
+  // After the deadline, the placer may have left some edges without a page.
+  if (prevCr < newCr || Deadline::passed())
   {
-    gr->loadFrom(grBck);
+    for (unsigned i = 0; i < gr->e.size(); i++)
+      gr->e[i].p = pagesBck[i];
+    gr->restoreNeighs();
     return prevCr;
   }
   else
@@ -368,91 +771,172 @@ int Tools::restartEdges(Graph *gr, int prevCr, void (*placer)(Graph *gr))
   }
 }
 
-class BestPosFinderEdge
+/**
+ * The edges from the vertex x that is being moved to its best position. The vertex x is virtually
+ * removed from the drawing and inserted into a gap between two consecutive other vertices;
+ * positions are the original positions in the graph, which is never changed.
+ * For every edge from x and every page, keeps the number of crossings the edge would have on that page.
+ */
+class BestPosFinder
 {
  public:
-  BestPosFinderEdge(int v2In, int pageCntIn)
-      : v2(v2In),
-        pageCr(pageCntIn, 0)
+  BestPosFinder(const Graph &gr, int xIn)
+      : x(xIn),
+        pageCnt(gr.p)
   {
+    for (const Edge *ed : gr.v[x].neighs)
+      ends.push_back(std::make_pair(ed->getOtherEnd(x), ed->p));
+    std::sort(ends.begin(), ends.end());
+    for (const std::pair<int, int> &end : ends)
+      v2.push_back(end.first);
+    int d = static_cast<int>(ends.size());
+    pageCr.assign(d * pageCnt, 0);
+    diff.assign((d + 1) * pageCnt, 0);
   }
+
+  /**
+   * Fills the crossings when x is put before all the other vertices.
+   * Such an edge crosses the edges that do not contain x and that go over its other end-point.
+   * The vertices are swept from left to right while keeping the number of edges going over
+   * the current vertex on every page; all the edges from x are processed in this one pass.
+   * Time O(n + m + deg(x)*pageCnt).
+   */
   void fillCrossingsAtZero(const Graph &gr)
   {
-    for (const Edge &ed : gr.e)
+    vector<int> over(pageCnt, 0);
+    std::size_t next = 0;
+    for (int k = 0; k < static_cast<int>(gr.v.size()); k++)
     {
-      if (ed.v1 <= v2 && ed.v2 <= v2)  // ed lies under this edge
+      if (k == x)
         continue;
-      if (ed.v1 >= v2 && ed.v2 >= v2)  // ed lies to the right of this edge
-        continue;
-      if (ed.v1 == 0 || ed.v2 == 0)  // ed shares a vertex with this -> no crossing
-        continue;
-      pageCr[ed.p]++;
+      for (const Edge *ed : gr.v[k].neighs)
+      {
+        int other = ed->getOtherEnd(k);
+        if (other != x && other < k)
+          over[ed->p]--;
+      }
+      for (; next < v2.size() && v2[next] == k; next++)
+        std::copy(over.begin(), over.end(), pageCr.begin() + next * pageCnt);
+      for (const Edge *ed : gr.v[k].neighs)
+      {
+        int other = ed->getOtherEnd(k);
+        if (other != x && other > k)
+          over[ed->p]++;
+      }
     }
   }
+
   /**
-   * Moving from in between v-1 and v to in between v and v+1.
+   * Moving x from in between the previous vertex and v to in between v and the next vertex.
+   * An edge at v with the other end-point w changes its crossing state with exactly those edges from x
+   * that share no vertex with it; it starts crossing those whose end-point is strictly between v and w
+   * iff w < v, and the others (outside of [v,w]) conversely. These are two ranges in v2,
+   * so the changes are collected in difference arrays.
+   * Time O(deg(v)*log(deg(x)) + deg(x)*pageCnt).
    */
   void updateCrossingsWhenMovingOver(const Graph &gr, int v)
   {
-    assert(v != 0);
+    assert(v != x);
+    int d = static_cast<int>(v2.size());
     for (const Edge *ed : gr.v[v].neighs)
     {
-      int edv2 = ed->getOtherEnd(v);
-      if (v2 == v || edv2 == 0 || edv2 == v2)  // ed shares a vertex with this -> no crossing
+      int w = ed->getOtherEnd(v);
+      if (w == x || w == v)
         continue;
-      bool crossedBefore = false;
-      if (edv2 < v && (v2 > v || v2 < edv2))
-        crossedBefore = true;
-      if (edv2 > v && v2 > v && v2 < edv2)
-        crossedBefore = true;
-      pageCr[ed->p] += (crossedBefore ? -1 : 1);
+      int lo = std::min(v, w);
+      int hi = std::max(v, w);
+      int sign = (w < v ? 1 : -1);
+      int *pageDiff = &diff[ed->p * (d + 1)];
+      int loBeg = std::lower_bound(v2.begin(), v2.end(), lo) - v2.begin();
+      int loEnd = std::upper_bound(v2.begin() + loBeg, v2.end(), lo) - v2.begin();
+      int hiBeg = std::lower_bound(v2.begin() + loEnd, v2.end(), hi) - v2.begin();
+      int hiEnd = std::upper_bound(v2.begin() + hiBeg, v2.end(), hi) - v2.begin();
+      // -sign everywhere, then +sign to [lo,hi] cancels it there, and +sign more to (lo,hi).
+      pageDiff[0] -= sign;
+      pageDiff[loBeg] += sign;
+      pageDiff[hiEnd] -= sign;
+      pageDiff[loEnd] += sign;
+      pageDiff[hiBeg] -= sign;
+    }
+    for (int p = 0; p < pageCnt; p++)
+    {
+      int *pageDiff = &diff[p * (d + 1)];
+      int cur = 0;
+      for (int i = 0; i < d; i++)
+      {
+        cur += pageDiff[i];
+        pageDiff[i] = 0;
+        pageCr[i * pageCnt + p] += cur;
+      }
+      pageDiff[d] = 0;
     }
   }
 
-  int v2;
-  vector<int> pageCr;
+  /**
+   * Crossings of the edges from x if each of them is on its best page.
+   */
+  int bestPagesCrossings() const
+  {
+    int result = 0;
+    for (std::size_t i = 0; i < v2.size(); i++)
+      result += *std::min_element(pageCr.begin() + i * pageCnt,
+                                  pageCr.begin() + (i + 1) * pageCnt);
+    return result;
+  }
+
+  /**
+   * Crossings of the edges from x if each of them is on its current page.
+   */
+  int currentPagesCrossings() const
+  {
+    int result = 0;
+    for (std::size_t i = 0; i < v2.size(); i++)
+      result += pageCr[i * pageCnt + ends[i].second];
+    return result;
+  }
+
+ private:
+  int x;
+  int pageCnt;
+  vector<std::pair<int, int> > ends;  ///< The other end-points and the pages of the edges from x, sorted.
+  vector<int> v2;  ///< Only the other end-points.
+  vector<int> pageCr;  ///< pageCr[i*pageCnt + p] are the crossings of the i-th edge if it were on page p.
+  vector<int> diff;  ///< Pending changes of pageCr, one difference array for every page.
 };
 
 /**
  * Find the best position for the vertex, excluding the original position.
  * Returns the change in the crossing number (negative = improvement).
- * The graph gr is unchanged.
- * Time O(deg(origPos)*m) ~ O(m^2/n).
+ * The graph gr is unchanged (and not copied); the vertex is moved only virtually.
+ * Time O(m*log(deg(origPos)) + n*deg(origPos)*pageCnt).
  */
 int Tools::findBestPositionForVertex(const Graph &gr, int origPos,
                                      int *finalPos)
 {
   assert (gr.v.size() != 1);
-  Graph mGr = Graph(gr);
-  moveVertex(&mGr, origPos, 0);
-
-  // Number of crossings of edges going from the studied vertex when the vertex is at original position
-  // We cannot get this value later, since the vertex might have been not initially greedy-optimal.
-  int origDiff = countEdgesFromVertexCrossings(gr, gr.v[origPos]);
 
-  vector<BestPosFinderEdge> allPageE;
-  for (Edge *e : mGr.v[0].neighs)
-  {
-    BestPosFinderEdge newE = BestPosFinderEdge(e->getOtherEnd(0), gr.p);
-    newE.fillCrossingsAtZero(mGr);
-    allPageE.push_back(newE);
-  }
+  BestPosFinder finder(gr, origPos);
+  finder.fillCrossingsAtZero(gr);
 
+  // Number of crossings of edges going from the studied vertex when the vertex is at original position
+  // It is taken with the original pages, since the vertex might have been not initially greedy-optimal.
+  int origDiff = 0;
   int bestDiff = 0;  // number of crossings of edges going from the studied vertex when the vertex is at best position (original position excluded)
   int best = -1;
-  for (std::size_t j = 0; j < gr.v.size(); j++)
+  for (int j = 0; j < static_cast<int>(gr.v.size()); j++)
   {
+    // Position j means that the vertex is right after the j-th other vertex (counted from 1).
     if (j > 0)
-      for (BestPosFinderEdge &e : allPageE)
-        e.updateCrossingsWhenMovingOver(mGr, j);
+      finder.updateCrossingsWhenMovingOver(gr, j - 1 < origPos ? j - 1 : j);
 
-    int curDiff = 0;
-    for (const BestPosFinderEdge &ed : allPageE)
-      curDiff += *(std::min_element(ed.pageCr.begin(), ed.pageCr.end()));
-
-    if (static_cast<int>(j) == origPos)
+    if (j == origPos)
+    {
+      origDiff = finder.currentPagesCrossings();
+      assert(origDiff == countEdgesFromVertexCrossings(gr, gr.v[origPos]));
       continue;
+    }
 
+    int curDiff = finder.bestPagesCrossings();
     if (best < 0 || curDiff <= bestDiff)
     {
       bestDiff = curDiff;
@@ -463,3 +947,178 @@ int Tools::findBestPositionForVertex(const Graph &gr, int origPos,
   *finalPos = best;
   return retval;
 }
+
+/**
+ * Counts crossings of the edge ed with the other edges of fg.
+ * The edges going over ed are exactly the slots of the vertices strictly inside ed, which form
+ * one contiguous range, scanned by SpanKernels.
+ * Time O(m), but faster if ed is short.
+ */
+int Tools::countEdgeCrossings(const FlatGraph &fg, int ed)
+{
+  int v1 = std::min(fg.ev1[ed], fg.ev2[ed]);
+  int v2 = std::max(fg.ev1[ed], fg.ev2[ed]);
+  if (v2 - v1 < 2)
+    return 0;
+  return SpanKernels::countCrossings(fg.adjOther.data(), fg.adjPage.data(),
+                                     fg.offs[v1 + 1], fg.offs[v2], v1, v2,
+                                     fg.ep[ed]);
+}
+
+/**
+ * O(m^2) (one m is smaller if the edges are short)
+ */
+int Tools::countCrossingNumber(const FlatGraph &fg)
+{
+  long long m = fg.edgeCnt();
+  int result = parallelSum(fg.edgeCnt(), m * m, [&fg](int beg, int end)
+  {
+    int sum = 0;
+    for (int i = beg; i < end; i++)
+      sum += countEdgeCrossings(fg, i);
+    return sum;
+  });
+  result >>= 1;  // every crossing was counted twice
+  return result;
+}
+
+/**
+ * The same as countCrossingNumberFast for Graph.
+ * Time O(n + m log n).
+ */
+int Tools::countCrossingNumberFast(const FlatGraph &fg)
+{
+  vector<int> pageBeg, left, right;
+  sortEdgesByPage(fg, true, pageBeg, left, right, nullptr);
+  int result = sweepSortedEdges(fg.vertexCnt(), pageBeg, left, right, nullptr,
+                                nullptr);
+  assert(result == countCrossingNumber(fg));
+  return result;
+}
+
+/**
+ * The same as greedyEdgePage for Graph.
+ * Time O(m), but faster if ed is short.
+ */
+bool Tools::greedyEdgePage(FlatGraph *fg, int ed)
+{
+  int v1 = std::min(fg->ev1[ed], fg->ev2[ed]);
+  int v2 = std::max(fg->ev1[ed], fg->ev2[ed]);
+
+  vector<unsigned> pageValue(fg->p, 0);
+  if (v2 - v1 >= 2)
+    SpanKernels::pageHistogram(fg->adjOther.data(), fg->adjPage.data(),
+                               fg->offs[v1 + 1], fg->offs[v2], v1, v2, fg->p,
+                               pageValue.data());
+
+  int origPage = fg->ep[ed];
+  int best = origPage;
+
+  // Find the best page other than the original.
+  for (int pCur = 0; pCur < fg->p; pCur++)
+    if (pCur != origPage)
+      if (best < 0 || pageValue[pCur] <= pageValue[best])
+        best = pCur;
+
+  if (best < 0)  // may happen if there is only one page
+    return false;
+  fg->setPage(ed, best);
+  return (origPage < 0 || pageValue[best] < pageValue[origPage]);
+}
+
+/**
+ * The same as greedyPages for Graph.
+ */
+void Tools::greedyPages(FlatGraph *fg)
+{
+  bool improved = true;
+  while (improved)
+  {
+    improved = false;
+    for (int i = 0; i < fg->edgeCnt(); i++)
+      if (greedyEdgePage(fg, i))
+        improved = true;
+  }
+}
+
+/**
+ * Move a single vertex from vOld to vNew.
+ * The slots of the vertices between vOld and vNew form one block, in which the slots of vOld
+ * are rotated to the other end; then the edges of the slots in the block are updated.
+ * Time: O(|vOld - vNew| + sum of degrees of the shifted vertices)
+ */
+void Tools::moveVertex(FlatGraph *fg, int vOld, int vNew)
+{
+  if (vOld == vNew)
+    return;
+  int lo = std::min(vOld, vNew);
+  int hi = std::max(vOld, vNew);
+  int deg = fg->offs[vOld + 1] - fg->offs[vOld];
+  int sBeg = fg->offs[lo];
+  int sEnd = fg->offs[hi + 1];
+  // In the block, the slots of vOld either go from the beginning to the end, or vice versa.
+  int mid = (vOld < vNew ? sBeg + deg : sEnd - deg);
+  std::rotate(fg->adjEdge.begin() + sBeg, fg->adjEdge.begin() + mid,
+              fg->adjEdge.begin() + sEnd);
+  std::rotate(fg->adjOther.begin() + sBeg, fg->adjOther.begin() + mid,
+              fg->adjOther.begin() + sEnd);
+  std::rotate(fg->adjPage.begin() + sBeg, fg->adjPage.begin() + mid,
+              fg->adjPage.begin() + sEnd);
+  std::rotate(fg->adjSide.begin() + sBeg, fg->adjSide.begin() + mid,
+              fg->adjSide.begin() + sEnd);
+  if (vOld < vNew)
+  {
+    std::rotate(fg->id.begin() + lo, fg->id.begin() + lo + 1,
+                fg->id.begin() + hi + 1);
+    for (int i = lo + 1; i <= hi; i++)
+      fg->offs[i] = fg->offs[i + 1] - deg;
+  }
+  else
+  {
+    std::rotate(fg->id.begin() + lo, fg->id.begin() + hi,
+                fg->id.begin() + hi + 1);
+    for (int i = hi; i > lo; i--)
+      fg->offs[i] = fg->offs[i - 1] + deg;
+  }
+
+  // First the new positions and slots of all the edges of the block are set, then the other end-points
+  // stored in the twin slots, which are now all valid.
+  for (int i = lo; i <= hi; i++)
+    for (int s = fg->offs[i]; s < fg->offs[i + 1]; s++)
+    {
+      int ed = fg->adjEdge[s];
+      if (fg->adjSide[s] == 0)
+      {
+        fg->ev1[ed] = i;
+        fg->slot1[ed] = s;
+      }
+      else
+      {
+        fg->ev2[ed] = i;
+        fg->slot2[ed] = s;
+      }
+    }
+  for (int i = lo; i <= hi; i++)
+    for (int s = fg->offs[i]; s < fg->offs[i + 1]; s++)
+    {
+      int ed = fg->adjEdge[s];
+      if (fg->adjSide[s] == 0)
+        fg->adjOther[fg->slot2[ed]] = i;
+      else
+        fg->adjOther[fg->slot1[ed]] = i;
+    }
+}
+
+/**
+ * Swap vertices vA and vB, done by two moves.
+ * Time: O(|vA - vB| + sum of degrees of the vertices between them)
+ */
+void Tools::swapVertices(FlatGraph *fg, int vA, int vB)
+{
+  if (vA == vB)
+    return;
+  int lo = std::min(vA, vB);
+  int hi = std::max(vA, vB);
+  moveVertex(fg, lo, hi);
+  moveVertex(fg, hi - 1, lo);
+}
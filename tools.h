@@ -1,9 +1,13 @@
 #ifndef BOOK_EMBEDDER_TOOLS_H_
 #define BOOK_EMBEDDER_TOOLS_H_
 
+#include <algorithm>
+#include <functional>
 #include <vector>
 
 #include "graph.h"
+#include "flatgraph.h"
+#include "undolog.h"
 
 class Tools
 {
@@ -16,6 +20,10 @@ class Tools
 
   static int countCrossingNumber(const Graph &gr);
 
+  static int countCrossingNumberFast(const Graph &gr);
+
+  static int countCrossingsPerEdge(const Graph &gr, std::vector<int> &cr);
+
   static int countCrossingsOfEdgesFromNeighbors(const Graph &gr, int v1);
 
   static int countCrossingChangeIfNeighborsSwapped(const Graph &gr, int v1);
@@ -30,10 +38,23 @@ class Tools
 
   static void swapVertices(Graph *gr, int vA, int vB);
 
+  static double averageSpanScan(const Graph &gr);
+
+  static void storeDrawing(const Graph &gr, std::vector<int> *ids, std::vector<int> *pages);
+
+  static void buildDrawing(const Graph &origGr, const std::vector<int> &ids,
+                           const std::vector<int> &pages, Graph *target);
+
   static bool greedyEdgePage(Graph *gr, Edge *ed);
 
   static void greedyAtVertex(Graph *gr, int v);
 
+  static void moveVertex(Graph *gr, int vOld, int vNew, UndoLog *log);
+
+  static void greedyAtVertex(Graph *gr, int v, UndoLog *log);
+
+  static void rollback(Graph *gr, UndoLog *log);
+
   static void greedyPages(Graph *gr);
 
   static int findBestPositionForVertex(const Graph &gr, int origPos, int *finalPos);
@@ -42,7 +63,67 @@ class Tools
 
   static int restartEdges(Graph *gr, int prevCr, void (*placer)(Graph *gr));
 
+  static int countEdgeCrossings(const FlatGraph &fg, int ed);
+
+  static int countCrossingNumber(const FlatGraph &fg);
+
+  static int countCrossingNumberFast(const FlatGraph &fg);
+
+  static bool greedyEdgePage(FlatGraph *fg, int ed);
+
+  static void greedyPages(FlatGraph *fg);
+
+  static void moveVertex(FlatGraph *fg, int vOld, int vNew);
+
+  static void swapVertices(FlatGraph *fg, int vA, int vB);
+
+  /**
+   * The number of threads used by the whole-graph evaluations (countCrossingNumber,
+   * countCrossingNumberFast, countCrossingsPerEdge and countEdgesGraphCrossings); 1 by default.
+   * Should be set before the search threads are started.
+   */
+  static void setEvalThreads(int threadCnt)
+  {
+    evalThreads_ = std::max(1, threadCnt);
+  }
+
+  static int evalThreads()
+  {
+    return evalThreads_;
+  }
+
  private:
+  static int evalThreads_;
+
+  /**
+   * Evaluations with less work (roughly the number of edge pairs, or of edges for the sweeps)
+   * are never split among threads.
+   */
+  static const long long minParallelWork = 1 << 16;
+  /**
+   * moveVertex updates only the edges at the shifted vertices if the window is shorter than
+   * n / moveVertexWindowFactor; otherwise it remaps all the edges sequentially.
+   */
+  static const int moveVertexWindowFactor = 8;
+
+  static void sortEdgesByPage(const Graph &gr, bool leftToRight, std::vector<int> &pageBeg,
+                              std::vector<int> &from, std::vector<int> &to,
+                              std::vector<int> *edgeIdx);
+
+  static void sortEdgesByPage(const FlatGraph &fg, bool leftToRight, std::vector<int> &pageBeg,
+                              std::vector<int> &from, std::vector<int> &to,
+                              std::vector<int> *edgeIdx);
+
+  static int sweepSortedEdges(int n, const std::vector<int> &pageBeg, const std::vector<int> &from,
+                              const std::vector<int> &to, const std::vector<int> *edgeIdx,
+                              std::vector<int> *cr);
+
+  static int sweepBuckets(int n, const std::vector<int> &pageBeg, const std::vector<int> &from,
+                          const std::vector<int> &to, const std::vector<int> *edgeIdx,
+                          std::vector<int> *cr, int bucketBeg, int bucketEnd);
+
+  static int parallelSum(int cnt, long long work, const std::function<int(int, int)> &rangeSum);
+
   static void countEdgesVertexCrossingsImpl(const Graph &gr, int v1, std::vector<Edge> &eList,
                                     int factor);
 };
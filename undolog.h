@@ -0,0 +1,62 @@
+/**
+ * Journal of the changes of a drawing, so that a rejected move can be rolled back.
+ *
+ * Program for minimizing the number of crossings in a book embedding of a given
+ * graph to a given number of pages.
+ *
+ * Author: Josef Cibulka
+ * License: see the file LICENSE
+ */
+#ifndef BOOK_EMBEDDER_UNDOLOG_H_
+#define BOOK_EMBEDDER_UNDOLOG_H_
+
+#include <vector>
+
+/**
+ * The changes are recorded by the Tools methods that take an UndoLog and replayed in reverse
+ * by Tools::rollback. The storage is kept between the moves, so recording does not allocate
+ * once the log has grown to the size of the largest move.
+ */
+class UndoLog
+{
+ public:
+  /**
+   * Edge with the index ed had the page oldPage before the change.
+   */
+  void recordPage(int ed, int oldPage)
+  {
+    entries_.push_back(Entry { ed, oldPage, 0 });
+  }
+
+  /**
+   * The vertex at position vOld was moved to position vNew.
+   */
+  void recordMove(int vOld, int vNew)
+  {
+    entries_.push_back(Entry { -1, vOld, vNew });
+  }
+
+  void clear()
+  {
+    entries_.clear();
+  }
+
+  bool empty() const
+  {
+    return entries_.empty();
+  }
+
+ private:
+  friend class Tools;
+
+  struct Entry
+  {
+    int ed;  ///< The edge whose page changed, -1 for a move of a vertex.
+    int a;  ///< The old page, or the old position of the moved vertex.
+    int b;  ///< The new position of the moved vertex.
+  };
+
+  std::vector<Entry> entries_;
+};
+
+#endif